@@ -19,6 +19,7 @@
 
 #include "sysdep.h"
 #include "wpixmaps.h"
+#include "wpixres.h"
 #include "prefs.h"
 #include "intl.h"
 #include "udir.h"
@@ -827,6 +828,9 @@ YApm::YApm(YWindow *aParent, bool autodetect):
     FILE *pmu_info;
     char buf[300];
 
+    if (prettyClock)
+        WPixRes::initPixmaps(WPixRes::pgLedClock);
+
     //search for acpi info first
 #if !defined(__FreeBSD__) && !defined(__FreeBSD_kernel__)
     adir dir("/sys/class/power_supply");
@@ -905,6 +909,7 @@ YApm::YApm(YWindow *aParent, bool autodetect):
 
     updateState();
 
+    apmTimer->setSampling();
     apmTimer->setTimer(1000 * batteryPollingPeriod, this, true);
 
     if (taskBarShowApmGraph)
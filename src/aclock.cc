@@ -13,6 +13,7 @@
 #include "sysdep.h"
 #include "applet.h"
 #include "wpixmaps.h"
+#include "wpixres.h"
 #include "wmapp.h"
 #include "prefs.h"
 #include "ymenuitem.h"
@@ -48,6 +49,8 @@ YClock::YClock(YSMListener *smActionListener, IAppletContainer* iapp, YWindow *a
     memset(positions, 0, sizeof positions);
     memset(previous, 0, sizeof previous);
 
+    if (prettyClock)
+        WPixRes::initPixmaps(WPixRes::pgLedClock);
     if (prettyClock && ledPixSpace != null && ledPixSpace->width() == 1)
         ledPixSpace = ledPixSpace->scale(5, ledPixSpace->height());
 
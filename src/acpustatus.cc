@@ -93,6 +93,7 @@ CPUStatus::CPUStatus(YWindow *aParent, CPUStatusHandler *aHandler, int cpuid) :
     color[IWM_IDLE] = &clrCpuIdle;
     color[IWM_STEAL] = &clrCpuSteal;
 
+    fUpdateTimer->setSampling();
     fUpdateTimer->setTimer(taskBarCPUDelay, this, true);
 
     setSize(taskBarCPUSamples, taskBarGraphHeight);
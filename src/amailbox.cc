@@ -12,6 +12,7 @@
 #include "prefs.h"
 #include "wmapp.h"
 #include "wpixmaps.h"
+#include "wpixres.h"
 #include "udir.h"
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -676,6 +677,7 @@ MailBoxStatus::MailBoxStatus(MailHandler* handler,
     fUnread(0),
     fSuspended(false)
 {
+    WPixRes::initPixmaps(WPixRes::pgMailbox);
     setSize(16, 16);
     setTitle("MailBox");
     if (mailbox != null) {
@@ -686,6 +688,7 @@ MailBoxStatus::MailBoxStatus(MailHandler* handler,
             long delay = check.ssl() ? max(30, mailCheckDelay)
                        : check.net() ? max(10, mailCheckDelay)
                        : mailCheckDelay;
+            fMailboxCheckTimer->setSampling();
             fMailboxCheckTimer->setTimer(delay * 1000L, this, true);
         }
     }
@@ -29,6 +29,7 @@ MEMStatus::MEMStatus(IAppletContainer* taskBar, YWindow *aParent):
     unchanged(taskBarMEMSamples),
     taskBar(taskBar)
 {
+    fUpdateTimer->setSampling();
     fUpdateTimer->setTimer(taskBarMEMDelay, this, true);
 
     color[MEM_USER] = &clrMemUser;
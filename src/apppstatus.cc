@@ -646,6 +646,7 @@ NetStatusControl::NetStatusControl(IApp* app, YSMListener* smActionListener,
     }
     interfaces.clear();
 
+    fUpdateTimer->setSampling();
     fUpdateTimer->setTimer(taskBarNetDelay, this, true);
 }
 
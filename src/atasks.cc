@@ -539,6 +539,22 @@ TaskBarApp* TaskPane::findApp(YFrameWindow *frame) {
     return task ? *task : 0;
 }
 
+int TaskPane::position(YFrameWindow *frame) {
+    TaskBarApp* task = findApp(frame);
+    return task ? find(fApps, task) : -1;
+}
+
+void TaskPane::moveApp(YFrameWindow *frame, int position) {
+    int k = this->position(frame);
+    if (k >= 0 && inrange(position, 0, fApps.getCount() - 1)) {
+        for (; k > position; --k)
+            fApps.swap(k, k - 1);
+        for (; k < position; ++k)
+            fApps.swap(k, k + 1);
+        relayout();
+    }
+}
+
 TaskBarApp* TaskPane::getActive() {
     return findApp(manager->getFocus());
 }
@@ -71,6 +71,10 @@ public:
     void remove(TaskBarApp *tapp);
     TaskBarApp *addApp(YFrameWindow *frame);
     TaskBarApp *findApp(YFrameWindow *frame);
+    // the position of the task of this frame, or -1
+    int position(YFrameWindow *frame);
+    // move the task of this frame to another position
+    void moveApp(YFrameWindow *frame, int position);
     TaskBarApp *getActive();
     TaskBarApp *predecessor(TaskBarApp *tapp);
     TaskBarApp *successor(TaskBarApp *tapp);
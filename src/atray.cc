@@ -417,8 +417,7 @@ void TrayPane::configure(const YRect2& r) {
             }
             repaint();
             XEvent xev;
-            while (XCheckWindowEvent(xapp->display(), handle(),
-                                     ExposureMask, &xev)
+            while (xapp->checkMaskEvent(handle(), ExposureMask, &xev)
                 && ((xev.type == Expose && 0 < xev.xexpose.count) ||
                 (xev.type == GraphicsExpose && 0 < xev.xgraphicsexpose.count)));
         }
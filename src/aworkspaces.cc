@@ -609,10 +609,13 @@ void WorkspaceButton::paint(Graphics &g, const YRect& r) {
             getColor().darker()
         };
 
-        for (YFrameWindow *yfw = manager->bottomLayer(WinLayerBelow);
-                yfw && yfw->getActiveLayer() <= WinLayerDock;
-                yfw = yfw->prevLayer()) {
-            if (yfw->isHidden() ||
+        YArray<YFrameWindow*> frames;
+        manager->stackedOn(fWorkspace, frames);
+        for (int i = frames.getCount(); 0 < i--; ) {
+            YFrameWindow* yfw = frames[i];
+            if (yfw->getActiveLayer() < WinLayerBelow ||
+                yfw->getActiveLayer() > WinLayerDock ||
+                yfw->isHidden() ||
                 hasbit(yfw->frameOptions(),
                        YFrameWindow::foIgnoreWinList |
                        YFrameWindow::foIgnorePagerPreview)) {
@@ -291,6 +291,7 @@ void YFrameWindow::layoutShape() {
 
 void YFrameWindow::configure(const YRect2& r) {
     MSG(("configure %d %d %d %d", r.x(), r.y(), r.width(), r.height()));
+    manager->reindexFrame(this, r.old);
 
     if (r.resized()) {
         performLayout();
@@ -482,10 +483,15 @@ unsigned YFrameWindow::overlap(YFrameWindow* f) {
 }
 
 bool YFrameWindow::overlaps(bool isAbove) {
-    YFrameWindow* f = isAbove ? prev() : next();
-    for (; f; f = isAbove ? f->prev() : f->next())
-        if (overlap(f))
+    const int rank = manager->stackRank(this);
+    YArray<YFrameWindow*> found;
+    manager->framesAt(geometry(), manager->activeWorkspace(), found);
+    for (int i = 0; i < found.getCount(); ++i) {
+        YFrameWindow* f = found[i];
+        if (f != this && f->getActiveLayer() == getActiveLayer() &&
+            (manager->stackRank(f) < rank) == isAbove && overlap(f))
             return true;
+    }
     return false;
 }
 
@@ -181,6 +181,7 @@ static NAtom ATOM_WIN_TRAY(XA_WIN_TRAY);
 static NAtom ATOM_WIN_PROTOCOLS(XA_WIN_PROTOCOLS);
 static NAtom ATOM_GUI_EVENT(XA_GUI_EVENT_NAME);
 static NAtom ATOM_ICE_ACTION("_ICEWM_ACTION");
+static NAtom ATOM_ICE_EVENT_STATS("_ICEWM_EVENT_STATS");
 static NAtom ATOM_ICE_WINOPT("_ICEWM_WINOPTHINT");
 static NAtom ATOM_MOTIF_HINTS(_XA_MOTIF_WM_HINTS);
 static NAtom ATOM_NET_CLIENT_LIST("_NET_CLIENT_LIST");
@@ -1300,6 +1301,7 @@ private:
     bool isAction(const char* str, int argCount);
     bool icewmAction();
     bool guiEvents();
+    bool eventStats();
     bool listShown();
     bool listXembed();
     void listXembed(Window w);
@@ -2459,6 +2461,44 @@ bool IceSh::guiEvents()
     return true;
 }
 
+bool IceSh::eventStats()
+{
+    if ( !isAction("eventstats", 0))
+        return false;
+
+    XSelectInput(display, root, PropertyChangeMask);
+    send(ATOM_ICE_ACTION, root, CurrentTime, ICEWM_ACTION_EVENTSTATS);
+
+    const timeval expire(monotime() + 3L);
+    for (timeval now(monotime()); now < expire; now = monotime()) {
+        if (XPending(display)) {
+            XEvent xev = { 0 };
+            XNextEvent(display, &xev);
+            if (xev.type == PropertyNotify &&
+                xev.xproperty.atom == ATOM_ICE_EVENT_STATS &&
+                xev.xproperty.state == PropertyNewValue)
+            {
+                YProperty prop(root, ATOM_ICE_EVENT_STATS, XA_STRING, 1L << 16);
+                if (prop) {
+                    fwrite(prop.data<char>(), 1, prop.count(), stdout);
+                    flush();
+                }
+                return true;
+            }
+        }
+        else {
+            timeval wait(expire - now);
+            int fd = ConnectionNumber(display);
+            fd_set rfds;
+            FD_ZERO(&rfds);
+            FD_SET(fd, &rfds);
+            select(fd + 1, SELECT_TYPE_ARG234 &rfds, nullptr, nullptr, &wait);
+        }
+    }
+    msg(_("No event statistics from icewm."));
+    return true;
+}
+
 bool IceSh::icewmAction()
 {
     static const Symbol sa[] = {
@@ -2482,6 +2522,7 @@ bool IceSh::icewmAction()
     }
 
     return guiEvents()
+        || eventStats()
         || setWorkspaceNames()
         || setWorkspaceName()
         || listWorkspaces()
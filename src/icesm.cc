@@ -174,6 +174,7 @@ public:
     SessionManager(int *argc, char ***argv): YApplication(argc, argv) {
         options(argc, argv);
         startup_phase = 0;
+        startup_trace = nullptr;
         bg_pid = -1;
         wm_pid = -1;
         tray_pid = -1;
@@ -328,6 +329,8 @@ public:
             wm_pid = -1;
         }
         else {
+            if (startup_phase == 0 && startup_trace == nullptr)
+                startup_trace = new YTracePhase("icewm");
             const int size = 24;
             const char* args[size] = {
                 icewmExe, "--notify", nullptr
@@ -583,15 +586,21 @@ private:
     }
 
     void notified() {
-        if (++startup_phase == 1)
+        if (++startup_phase == 1) {
+            if (startup_trace)
+                startup_trace->init("icewmtray");
             runIcewmtray();
+        }
         else if (startup_phase == 2) {
+            delete startup_trace;
+            startup_trace = nullptr;
             runScript("startup");
         }
     }
 
 private:
     int startup_phase;
+    YTracePhase* startup_trace; // until icewm and icewmtray are ready
     int bg_pid;
     int wm_pid;
     int tray_pid;
@@ -708,12 +717,17 @@ void SessionManager::rescueFocus() {
 }
 
 int main(int argc, char **argv) {
+    YTracePhase phase("application");
     SessionManager xapp(&argc, &argv);
 
+    phase.init("environment");
     xapp.loadEnv("env");
 
+    phase.init("icewmbg");
     xapp.runIcewmbg();
+    phase.init("icesound");
     xapp.runIcesound();
+    phase.done();
     xapp.runWM();
 
     int status = xapp.mainLoop();
@@ -316,7 +316,9 @@ Background::~Background() {
 }
 
 int Background::mainLoop() {
+    YTracePhase phase("update");
     update();
+    phase.done();
     if (0 < cycleBackgroundsPeriod) {
         cycleTimer->setTimer(cycleBackgroundsPeriod * 1000L, this, true);
     }
@@ -1076,6 +1078,7 @@ int main(int argc, char **argv) {
         /*ignore*/;
     }
 
+    YTracePhase phase("application");
     Background bg(&argc, &argv, verbose);
 
     if (sendRestart) {
@@ -1097,6 +1100,7 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    phase.init("configuration");
     globalBg = &bg;
     bgLoadConfig(configFile, overrideTheme);
     if (image) {
@@ -1129,6 +1133,7 @@ int main(int argc, char **argv) {
     }
 
     globalBg = nullptr;
+    phase.done();
 
     return bg.mainLoop();
 }
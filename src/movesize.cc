@@ -99,7 +99,7 @@ void YFrameWindow::snapTo(int &wx, int &wy,
 }
 
 void YFrameWindow::snapTo(int &wx, int &wy) {
-    YFrameWindow *f = manager->topLayer();
+    YFrameWindow *f = nullptr;
     int flags = 1 | 2;
     int xp = wx, yp = wy;
     int rx1, ry1, rx2, ry2;
@@ -150,11 +150,24 @@ void YFrameWindow::snapTo(int &wx, int &wy) {
     flags &= ~4;
 
     if (flags & (1 | 2)) {
-        for (; f; f = f->nextLayer()) {
+        // only frames within snapping distance are candidates,
+        // which are tried in stacking order from the top
+        int d = snapDistance + 1;
+        YRect near(xp - d, yp - d, width() + 2 * d, height() + 2 * d);
+        YArray<YFrameWindow*> found;
+        manager->framesAt(near, manager->activeWorkspace(), found);
+        for (int i = 0; i < found.getCount(); ++i) {
+            int k = i;
+            for (int j = i + 1; j < found.getCount(); ++j)
+                if (manager->stackRank(found[j]) < manager->stackRank(found[k]))
+                    k = j;
+            f = found[k];
+            found[k] = found[i];
+
             if (affectsWorkArea() && f->inWorkArea())
                 continue;
 
-            if (f != this && f->visible()) {
+            if (f != this && f->visible() && f->visibleNow()) {
                 rx1 = f->x();
                 ry1 = f->y();
                 rx2 = f->x() + f->width();
@@ -420,6 +433,7 @@ void YFrameWindow::handleResizeMouse(const XMotionEvent &motion,
 void YFrameWindow::outlineMove() {
     int xx(x()), yy(y());
 
+    xapp->requeueEvents();
     XGrabServer(xapp->display());
 
     for (;;) {
@@ -497,6 +511,7 @@ void YFrameWindow::outlineResize() {
         incY = client()->sizeHints()->height_inc;
     }
 
+    xapp->requeueEvents();
     XGrabServer(xapp->display());
 
     for (;;) {
@@ -585,6 +600,7 @@ void YFrameWindow::manualPlace() {
                           PointerMotionMask))
         return;
 
+    xapp->requeueEvents();
     XGrabServer(xapp->display());
     statusMoveSize->begin(this);
 
@@ -733,83 +749,10 @@ bool YFrameWindow::handleKey(const XKeyEvent &key) {
                 key.window != handle())
                 return true;
 
-            if (IS_WMKEY(k, vm, gKeyWinClose)) {
-                if (canClose()) wmClose();
-            } else if (IS_WMKEY(k, vm, gKeyWinPrev)) {
-                wmPrevWindow();
-            } else if (IS_WMKEY(k, vm, gKeyWinMaximizeVert)) {
-                if (canMaximize()) wmMaximizeVert();
-            } else if (IS_WMKEY(k, vm, gKeyWinMaximizeHoriz)) {
-                if (canMaximize()) wmMaximizeHorz();
-            } else if (IS_WMKEY(k, vm, gKeyWinRaise)) {
-                if (canRaise()) wmRaise();
-            } else if (IS_WMKEY(k, vm, gKeyWinOccupyAll)) {
-                wmOccupyAllOrCurrent();
-            } else if (IS_WMKEY(k, vm, gKeyWinLower)) {
-                if (canLower()) wmLower();
-            } else if (IS_WMKEY(k, vm, gKeyWinRestore)) {
-                wmRestore();
-            } else if (IS_WMKEY(k, vm, gKeyWinNext)) {
-                wmNextWindow();
-            } else if (IS_WMKEY(k, vm, gKeyWinMove)) {
-                if (canMove()) wmMove();
-            } else if (IS_WMKEY(k, vm, gKeyWinSize)) {
-                if (canSize()) wmSize();
-            } else if (IS_WMKEY(k, vm, gKeyWinMinimize)) {
-                if (canMinimize()) wmMinimize();
-            } else if (IS_WMKEY(k, vm, gKeyWinMaximize)) {
-                if (canMaximize()) wmMaximize();
-            } else if (IS_WMKEY(k, vm, gKeyWinHide)) {
-                if (canHide()) wmHide();
-            } else if (IS_WMKEY(k, vm, gKeyWinRollup)) {
-                if (canRollup()) wmRollup();
-            } else if (IS_WMKEY(k, vm, gKeyWinFullscreen)) {
-                if (canFullscreen()) wmToggleFullscreen();
-            } else if (IS_WMKEY(k, vm, gKeyWinMenu)) {
-                popupSystemMenu(this);
-            } else if (IS_WMKEY(k, vm, gKeyWinArrangeN)) {
-                if (canMove()) wmArrange(waTop, waCenter);
-            } else if (IS_WMKEY(k, vm, gKeyWinArrangeNE)) {
-                if (canMove()) wmArrange(waTop, waRight);
-            } else if (IS_WMKEY(k, vm, gKeyWinArrangeE)) {
-                if (canMove()) wmArrange(waCenter, waRight);
-            } else if (IS_WMKEY(k, vm, gKeyWinArrangeSE)) {
-                if (canMove()) wmArrange(waBottom, waRight);
-            } else if (IS_WMKEY(k, vm, gKeyWinArrangeS)) {
-                if (canMove()) wmArrange(waBottom, waCenter);
-            } else if (IS_WMKEY(k, vm, gKeyWinArrangeSW)) {
-                if (canMove()) wmArrange(waBottom, waLeft);
-            } else if (IS_WMKEY(k, vm, gKeyWinArrangeW)) {
-                if (canMove()) wmArrange(waCenter, waLeft);
-            } else if (IS_WMKEY(k, vm, gKeyWinArrangeNW)) {
-                if (canMove()) wmArrange(waTop, waLeft);
-            } else if (IS_WMKEY(k, vm, gKeyWinArrangeC)) {
-                if (canMove()) wmArrange(waCenter, waCenter);
-            } else if (IS_WMKEY(k, vm, gKeyWinSnapMoveN)) {
-                if (canMove()) wmSnapMove(waTop, waCenter);
-            } else if (IS_WMKEY(k, vm, gKeyWinSnapMoveNE)) {
-                if (canMove()) wmSnapMove(waTop, waRight);
-            } else if (IS_WMKEY(k, vm, gKeyWinSnapMoveE)) {
-                if (canMove()) wmSnapMove(waCenter, waRight);
-            } else if (IS_WMKEY(k, vm, gKeyWinSnapMoveSE)) {
-                if (canMove()) wmSnapMove(waBottom, waRight);
-            } else if (IS_WMKEY(k, vm, gKeyWinSnapMoveS)) {
-                if (canMove()) wmSnapMove(waBottom, waCenter);
-            } else if (IS_WMKEY(k, vm, gKeyWinSnapMoveSW)) {
-                if (canMove()) wmSnapMove(waBottom, waLeft);
-            } else if (IS_WMKEY(k, vm, gKeyWinSnapMoveW)) {
-                if (canMove()) wmSnapMove(waCenter, waLeft);
-            } else if (IS_WMKEY(k, vm, gKeyWinSnapMoveNW)) {
-                if (canMove()) wmSnapMove(waTop, waLeft);
-            } else if (IS_WMKEY(k, vm, gKeyWinSmartPlace)) {
-                if (canMove()) {
-                    int newX = x();
-                    int newY = y();
-                    if (manager->getSmartPlace(true, this, newX, newY, width(), height(), getScreen())) {
-                        setCurrentPositionOuter(newX, newY);
-                    }
-                }
-            } else if (isIconic() || isRollup()) {
+            WinKeyAction action = manager->winKeyAction(k, vm);
+            if ((action == wkNone || handleWinKey(action) == false) &&
+                (isIconic() || isRollup()))
+            {
                 if (k == XK_Return || k == XK_KP_Enter) {
                     if (isMinimized())
                         wmMinimize();
@@ -824,6 +767,125 @@ bool YFrameWindow::handleKey(const XKeyEvent &key) {
     return true;
 }
 
+bool YFrameWindow::handleWinKey(WinKeyAction action) {
+    switch (action) {
+    case wkClose:
+        if (canClose()) wmClose();
+        break;
+    case wkPrev:
+        wmPrevWindow();
+        break;
+    case wkMaximizeVert:
+        if (canMaximize()) wmMaximizeVert();
+        break;
+    case wkMaximizeHoriz:
+        if (canMaximize()) wmMaximizeHorz();
+        break;
+    case wkRaise:
+        if (canRaise()) wmRaise();
+        break;
+    case wkOccupyAll:
+        wmOccupyAllOrCurrent();
+        break;
+    case wkLower:
+        if (canLower()) wmLower();
+        break;
+    case wkRestore:
+        wmRestore();
+        break;
+    case wkNext:
+        wmNextWindow();
+        break;
+    case wkMove:
+        if (canMove()) wmMove();
+        break;
+    case wkSize:
+        if (canSize()) wmSize();
+        break;
+    case wkMinimize:
+        if (canMinimize()) wmMinimize();
+        break;
+    case wkMaximize:
+        if (canMaximize()) wmMaximize();
+        break;
+    case wkHide:
+        if (canHide()) wmHide();
+        break;
+    case wkRollup:
+        if (canRollup()) wmRollup();
+        break;
+    case wkFullscreen:
+        if (canFullscreen()) wmToggleFullscreen();
+        break;
+    case wkMenu:
+        popupSystemMenu(this);
+        break;
+    case wkArrangeN:
+        if (canMove()) wmArrange(waTop, waCenter);
+        break;
+    case wkArrangeNE:
+        if (canMove()) wmArrange(waTop, waRight);
+        break;
+    case wkArrangeE:
+        if (canMove()) wmArrange(waCenter, waRight);
+        break;
+    case wkArrangeSE:
+        if (canMove()) wmArrange(waBottom, waRight);
+        break;
+    case wkArrangeS:
+        if (canMove()) wmArrange(waBottom, waCenter);
+        break;
+    case wkArrangeSW:
+        if (canMove()) wmArrange(waBottom, waLeft);
+        break;
+    case wkArrangeW:
+        if (canMove()) wmArrange(waCenter, waLeft);
+        break;
+    case wkArrangeNW:
+        if (canMove()) wmArrange(waTop, waLeft);
+        break;
+    case wkArrangeC:
+        if (canMove()) wmArrange(waCenter, waCenter);
+        break;
+    case wkSnapMoveN:
+        if (canMove()) wmSnapMove(waTop, waCenter);
+        break;
+    case wkSnapMoveNE:
+        if (canMove()) wmSnapMove(waTop, waRight);
+        break;
+    case wkSnapMoveE:
+        if (canMove()) wmSnapMove(waCenter, waRight);
+        break;
+    case wkSnapMoveSE:
+        if (canMove()) wmSnapMove(waBottom, waRight);
+        break;
+    case wkSnapMoveS:
+        if (canMove()) wmSnapMove(waBottom, waCenter);
+        break;
+    case wkSnapMoveSW:
+        if (canMove()) wmSnapMove(waBottom, waLeft);
+        break;
+    case wkSnapMoveW:
+        if (canMove()) wmSnapMove(waCenter, waLeft);
+        break;
+    case wkSnapMoveNW:
+        if (canMove()) wmSnapMove(waTop, waLeft);
+        break;
+    case wkSmartPlace:
+        if (canMove()) {
+            int newX = x();
+            int newY = y();
+            if (manager->getSmartPlace(true, this, newX, newY, width(), height(), getScreen())) {
+                setCurrentPositionOuter(newX, newY);
+            }
+        }
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
 void YFrameWindow::constrainPositionByModifier(int &x, int &y, const XMotionEvent &motion) {
     unsigned int mask = motion.state & (ShiftMask | ControlMask);
 
@@ -0,0 +1,149 @@
+#include "config.h"
+#include "yxcontext.h"
+#include "base.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <sys/time.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xresource.h>
+
+char const *ApplicationName("testcontext");
+
+class YWindow { };
+
+class watch {
+    double start;
+    char buf[42];
+public:
+    double time() const {
+        timeval now;
+        gettimeofday(&now, 0);
+        return now.tv_sec + 1e-6 * now.tv_usec;
+    }
+    watch() : start(time()) {}
+    double delta() const { return time() - start; }
+    const char* report() {
+        snprintf(buf, sizeof buf, "%.6f seconds", delta());
+        return buf;
+    }
+};
+
+// window ids as an X server hands them out to a few clients
+static Window windowId(int i) {
+    return ((1 + i % 7) << 21) + (i / 7) * 3 + 1;
+}
+
+static void test_basic() {
+    YContext<YWindow> context;
+    YWindow w[3];
+    YWindow* p = nullptr;
+
+    assert(context.find(1) == nullptr);
+    assert(context.remove(1) == false);
+    context.save(None, &w[0]);
+    assert(context.size() == 0);
+
+    context.save(10, &w[0]);
+    context.save(20, &w[1]);
+    assert(context.find(10) == &w[0]);
+    assert(context.find(20, &p) && p == &w[1]);
+    context.save(10, &w[2]);
+    assert(context.size() == 2);
+    assert(context.find(10) == &w[2]);
+    assert(context.remove(10));
+    assert(context.remove(10) == false);
+    assert(context.find(10) == nullptr);
+    assert(context.find(20) == &w[1]);
+    assert(context.size() == 1);
+    puts("basic: ok");
+}
+
+static void test_churn() {
+    const int count = 5000;
+    static YWindow w[count];
+    YContext<YWindow> context;
+
+    for (int i = 0; i < count; ++i)
+        context.save(windowId(i), &w[i]);
+    assert(context.size() == count);
+
+    // remove every third, then check all remaining entries are found
+    for (int i = 0; i < count; i += 3)
+        assert(context.remove(windowId(i)));
+    for (int i = 0; i < count; ++i)
+        assert(context.find(windowId(i)) == (i % 3 ? &w[i] : nullptr));
+
+    for (int i = 0; i < count; i += 3)
+        context.save(windowId(i), &w[i]);
+    for (int i = 0; i < count; ++i)
+        assert(context.find(windowId(i)) == &w[i]);
+
+    for (int i = count; 0 < i--; )
+        assert(context.remove(windowId(i)));
+    assert(context.size() == 0);
+    puts("churn: ok");
+}
+
+// XFindContext needs a display, without one only YContext is timed
+static void bench(Display* display, int windows, int lookups) {
+    YWindow* w = new YWindow[windows];
+    YContext<YWindow> context;
+    XContext xcontext = XUniqueContext();
+
+    for (int i = 0; i < windows; ++i) {
+        context.save(windowId(i), &w[i]);
+        if (display)
+            XSaveContext(display, windowId(i), xcontext,
+                         reinterpret_cast<const char *>(&w[i]));
+    }
+
+    long found = 0;
+    double xtime = 0;
+    if (display) {
+        watch x;
+        for (int k = 0; k < lookups; ++k) {
+            char* p = nullptr;
+            if (XFindContext(display, windowId(k % (2 * windows)),
+                             xcontext, &p) == 0)
+                found++;
+        }
+        xtime = x.delta();
+    }
+
+    watch y;
+    for (int k = 0; k < lookups; ++k) {
+        if (context.find(windowId(k % (2 * windows))))
+            found--;
+    }
+    double ytime = y.delta();
+
+    if (display) {
+        printf("%5d windows, %d lookups: XFindContext %.6f, YContext %.6f"
+               " seconds\n", windows, lookups, xtime, ytime);
+        assert(found == 0);
+        for (int i = 0; i < windows; ++i)
+            XDeleteContext(display, windowId(i), xcontext);
+    } else {
+        printf("%5d windows, %d lookups: YContext %.6f seconds\n",
+               windows, lookups, ytime);
+        assert(found == -lookups / 2);
+    }
+    delete[] w;
+}
+
+int main() {
+    test_basic();
+    test_churn();
+
+    Display* display = XOpenDisplay(nullptr);
+    bench(display, 100, 10000000);
+    bench(display, 1000, 10000000);
+    bench(display, 10000, 10000000);
+    if (display)
+        XCloseDisplay(display);
+    return 0;
+}
+
+// vim: set sw=4 ts=4 et:
@@ -0,0 +1,162 @@
+#include "config.h"
+#include "ycover.h"
+#include "base.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sys/time.h>
+
+char const *ApplicationName("testcover");
+
+class watch {
+    double start;
+public:
+    double time() const {
+        timeval now;
+        gettimeofday(&now, 0);
+        return now.tv_sec + 1e-6 * now.tv_usec;
+    }
+    watch() : start(time()) {}
+    double delta() const { return time() - start; }
+};
+
+static const int screenWidth = 1920;
+static const int screenHeight = 1080;
+
+static YRect randomRect() {
+    int w = 1 + rand() % 800;
+    int h = 1 + rand() % 600;
+    int x = rand() % (screenWidth + 400) - 200;
+    int y = rand() % (screenHeight + 400) - 200;
+    return YRect(x, y, w, h);
+}
+
+// the coverage as smart placement computed it: the first one counts twice
+static long long linear(const YRect& area, const YRect* rects, int count) {
+    long long cover = 0;
+    for (int i = 0; i < count; ++i)
+        cover += (long long) area.overlap(rects[i]) * (i ? 1 : 2);
+    return cover;
+}
+
+static void test_basic() {
+    YCoverage cover(YRect(0, 0, 100, 100));
+    cover.add(YRect(10, 10, 20, 20), 2);
+    cover.add(YRect(20, 20, 20, 20), 1);
+    cover.add(YRect(-50, 90, 200, 50), 3);
+    cover.build();
+    assert(cover.coverage(YRect(0, 0, 100, 100)) == 800 + 400 + 3000);
+    assert(cover.coverage(YRect(15, 15, 10, 10)) == 200 + 25);
+    assert(cover.coverage(YRect(40, 40, 10, 10)) == 0);
+    assert(cover.coverage(YRect(95, 95, 10, 10)) == 75);
+    assert(cover.coverage(YRect(25, 25, 1, 1)) == 3);
+    puts("basic: ok");
+}
+
+static void test_random() {
+    for (int round = 0; round < 100; ++round) {
+        const int count = 1 + rand() % 100;
+        YRect* rects = new YRect[count];
+        YRect bounds(0, 0, screenWidth, screenHeight);
+        YCoverage cover(bounds);
+        for (int i = 0; i < count; ++i) {
+            rects[i] = randomRect();
+            cover.add(rects[i], i ? 1 : 2);
+        }
+        cover.build();
+        for (int k = 0; k < 1000; ++k) {
+            YRect area(randomRect().intersect(bounds));
+            assert(cover.coverage(area) == linear(area, rects, count));
+        }
+        delete[] rects;
+    }
+    puts("random: ok");
+}
+
+// smart placement over the candidate positions at all edges
+template <class Coverage>
+static YRect place(int w, int h, const YRect* rects, int count,
+                   Coverage coverage)
+{
+    int* xs = new int[2 * count + 2];
+    int* ys = new int[2 * count + 2];
+    int nx = 0, ny = 0;
+    xs[nx++] = 0;
+    ys[ny++] = 0;
+    for (int i = 0; i < count; ++i) {
+        xs[nx++] = rects[i].x();
+        xs[nx++] = rects[i].x() + int(rects[i].width());
+        ys[ny++] = rects[i].y();
+        ys[ny++] = rects[i].y() + int(rects[i].height());
+    }
+    int px = 0, py = 0;
+    long long cover = coverage(YRect(0, 0, w, h));
+    for (int j = 0; j < ny && cover; ++j) {
+        for (int i = 0; i < nx && cover; ++i) {
+            const int cx[] = { xs[i] - w, xs[i] - w, xs[i], xs[i] };
+            const int cy[] = { ys[j] - h, ys[j], ys[j] - h, ys[j] };
+            for (int k = 0; k < 4; ++k) {
+                if (cx[k] < 0 || cy[k] < 0 ||
+                    cx[k] + w > screenWidth || cy[k] + h > screenHeight)
+                    continue;
+                long long c = coverage(YRect(cx[k], cy[k], w, h));
+                if (c < cover) {
+                    px = cx[k];
+                    py = cy[k];
+                    cover = c;
+                }
+            }
+        }
+    }
+    delete[] xs;
+    delete[] ys;
+    return YRect(px, py, w, h);
+}
+
+static void bench(int count, int windows) {
+    YRect* rects = new YRect[count];
+    for (int i = 0; i < count; ++i)
+        rects[i] = randomRect();
+    YRect* placed = new YRect[windows];
+    int* sizes = new int[2 * windows];
+    for (int i = 0; i < windows; ++i) {
+        sizes[2 * i] = 200 + rand() % 600;
+        sizes[2 * i + 1] = 150 + rand() % 400;
+    }
+
+    watch a;
+    for (int i = 0; i < windows; ++i)
+        placed[i] = place(sizes[2 * i], sizes[2 * i + 1], rects, count,
+            [&] (const YRect& r) { return linear(r, rects, count); });
+    double atime = a.delta();
+
+    watch b;
+    for (int i = 0; i < windows; ++i) {
+        YCoverage cover(YRect(0, 0, screenWidth, screenHeight));
+        for (int k = 0; k < count; ++k)
+            cover.add(rects[k], k ? 1 : 2);
+        cover.build();
+        YRect r(place(sizes[2 * i], sizes[2 * i + 1], rects, count,
+            [&] (const YRect& r) { return cover.coverage(r); }));
+        assert(r == placed[i]);
+    }
+    double btime = b.delta();
+
+    printf("%4d frames, %d placements: linear %.3f, table %.3f seconds\n",
+           count, windows, atime, btime);
+    delete[] rects;
+    delete[] placed;
+    delete[] sizes;
+}
+
+int main() {
+    srand(1);
+    test_basic();
+    test_random();
+    bench(50, 10);
+    bench(300, 3);
+    return 0;
+}
+
+// vim: set sw=4 ts=4 et:
@@ -0,0 +1,252 @@
+#include "config.h"
+#include "ygrid.h"
+#include "base.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+
+char const *ApplicationName("testgrid");
+
+struct Frame {
+    YRect rect;
+    int workspace;
+};
+
+class watch {
+    double start;
+public:
+    double time() const {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec * 1e3 + now.tv_nsec * 1e-6;
+    }
+    watch() : start(time()) {}
+    double delta() const { return time() - start; }
+};
+
+static const int screenWidth = 1920;
+static const int screenHeight = 1080;
+
+static YRect randomRect() {
+    int w = 100 + rand() % 700;
+    int h = 80 + rand() % 500;
+    int x = rand() % (screenWidth + 200) - 100;
+    int y = rand() % (screenHeight + 200) - 100;
+    return YRect(x, y, w, h);
+}
+
+static void test_basic() {
+    YGrid<Frame> grid(100);
+    grid.resize(1000, 500);
+    Frame f[3];
+    f[0].rect = YRect(0, 0, 50, 50);
+    f[1].rect = YRect(90, 90, 300, 200);
+    f[2].rect = YRect(-500, 400, 2000, 900);
+    for (int i = 0; i < 3; ++i)
+        grid.insert(&f[i], f[i].rect);
+    assert(grid.count() == 3);
+
+    YArray<Frame*> found;
+    grid.query(YRect(0, 0, 1000, 500), found);
+    assert(found.getCount() == 3);
+
+    found.clear();
+    grid.query(YRect(40, 40, 60, 60), found);
+    assert(found.getCount() == 2);
+
+    found.clear();
+    grid.query(YRect(50, 0, 40, 90), found);
+    assert(found.getCount() == 0);
+
+    found.clear();
+    grid.query(YRect(1200, 1200, 10, 10), found);
+    assert(found.getCount() == 1 && found[0] == &f[2]);
+
+    YRect old(f[1].rect);
+    f[1].rect = YRect(700, 0, 100, 100);
+    grid.update(&f[1], old, f[1].rect);
+    found.clear();
+    grid.query(YRect(100, 100, 10, 10), found);
+    assert(found.getCount() == 0);
+
+    grid.resize(3000, 2000);
+    assert(grid.count() == 3);
+    found.clear();
+    grid.query(YRect(750, 50, 1, 1), found);
+    assert(found.getCount() == 1 && found[0] == &f[1]);
+
+    assert(grid.remove(&f[0], f[0].rect));
+    assert(grid.remove(&f[0], f[0].rect) == false);
+    assert(grid.count() == 2);
+    puts("basic: ok");
+}
+
+static void test_random() {
+    const int count = 300;
+    Frame* frames = new Frame[count];
+    YGrid<Frame> grid;
+    grid.resize(screenWidth, screenHeight);
+    for (int i = 0; i < count; ++i) {
+        frames[i].rect = randomRect();
+        grid.insert(&frames[i], frames[i].rect);
+    }
+    for (int k = 0; k < 10000; ++k) {
+        int i = rand() % count;
+        YRect old(frames[i].rect);
+        frames[i].rect = randomRect();
+        grid.update(&frames[i], old, frames[i].rect);
+
+        YRect area(randomRect());
+        YArray<Frame*> found;
+        grid.query(area, found);
+        int expect = 0;
+        for (int j = 0; j < count; ++j)
+            if (area.overlap(frames[j].rect))
+                expect++;
+        assert(found.getCount() == expect);
+        for (int j = 0; j < found.getCount(); ++j)
+            assert(area.overlap(found[j]->rect));
+    }
+    assert(grid.count() == count);
+    delete[] frames;
+    puts("random: ok");
+}
+
+// the coverage of a placement as smart placement computes it:
+// frames on the same workspace, the top one counts twice
+static int coverage(const YRect& rect, int workspace,
+                    Frame* frames, int count)
+{
+    int cover = 0, factor = 2;
+    for (int i = 0; i < count; ++i) {
+        if (frames[i].workspace == workspace) {
+            cover += rect.overlap(frames[i].rect) * factor;
+            factor = 1;
+        }
+    }
+    return cover;
+}
+
+static int coverage(const YRect& rect, Frame* top, YGrid<Frame>& grid) {
+    int cover = 0;
+    grid.visit(rect, [&] (Frame* f) {
+        cover += rect.overlap(f->rect) * (f == top ? 2 : 1);
+    });
+    return cover;
+}
+
+static int insertSorted(int* v, int n, int c) {
+    int i = n;
+    for (int k = 0; k < n; ++k)
+        if (v[k] == c)
+            return n;
+    while (0 < i && c < v[i - 1]) {
+        v[i] = v[i - 1];
+        --i;
+    }
+    v[i] = c;
+    return n + 1;
+}
+
+// place a window at the candidate position with the least coverage
+static YRect place(int w, int h, int workspace, Frame* frames, int count,
+                   YGrid<Frame>* grid)
+{
+    int* xs = new int[2 * count + 2];
+    int* ys = new int[2 * count + 2];
+    int nx = insertSorted(xs, 0, 0), ny = insertSorted(ys, 0, 0);
+    Frame* top = nullptr;
+    for (int i = 0; i < count; ++i) {
+        if (frames[i].workspace != workspace)
+            continue;
+        if (top == nullptr)
+            top = &frames[i];
+        const YRect& r(frames[i].rect);
+        nx = insertSorted(xs, nx, r.x());
+        nx = insertSorted(xs, nx, r.x() + int(r.width()));
+        ny = insertSorted(ys, ny, r.y());
+        ny = insertSorted(ys, ny, r.y() + int(r.height()));
+    }
+    nx = insertSorted(xs, nx, screenWidth);
+    ny = insertSorted(ys, ny, screenHeight);
+
+    int px = 0, py = 0, cover = -1;
+    for (int j = 0; j < ny && cover; ++j) {
+        for (int i = 0; i < nx && cover; ++i) {
+            const int cx[] = { xs[i] - w, xs[i] - w, xs[i], xs[i] };
+            const int cy[] = { ys[j] - h, ys[j], ys[j] - h, ys[j] };
+            for (int k = 0; k < 4; ++k) {
+                if (cx[k] < 0 || cy[k] < 0 ||
+                    cx[k] + w > screenWidth || cy[k] + h > screenHeight)
+                    continue;
+                YRect rect(cx[k], cy[k], w, h);
+                int c = grid ? coverage(rect, top, grid[workspace])
+                             : coverage(rect, workspace, frames, count);
+                if (cover < 0 || c < cover) {
+                    px = cx[k];
+                    py = cy[k];
+                    cover = c;
+                }
+            }
+        }
+    }
+    delete[] xs;
+    delete[] ys;
+    return YRect(px, py, w, h);
+}
+
+// place windows on a desktop of count frames over some workspaces
+static void bench(int count, int workspaces, int windows) {
+    Frame* frames = new Frame[count];
+    YGrid<Frame>* grids = new YGrid<Frame>[workspaces];
+    for (int k = 0; k < workspaces; ++k)
+        grids[k].resize(screenWidth, screenHeight);
+    for (int i = 0; i < count; ++i) {
+        frames[i].rect = randomRect();
+        frames[i].workspace = i % workspaces;
+        grids[i % workspaces].insert(&frames[i], frames[i].rect);
+    }
+
+    YRect* linear = new YRect[windows];
+    int* sizes = new int[2 * windows];
+    for (int i = 0; i < windows; ++i) {
+        sizes[2 * i] = 200 + rand() % 600;
+        sizes[2 * i + 1] = 150 + rand() % 400;
+    }
+
+    watch a;
+    for (int i = 0; i < windows; ++i)
+        linear[i] = place(sizes[2 * i], sizes[2 * i + 1], i % workspaces,
+                          frames, count, nullptr);
+    double atime = a.delta();
+
+    watch b;
+    for (int i = 0; i < windows; ++i) {
+        YRect r(place(sizes[2 * i], sizes[2 * i + 1], i % workspaces,
+                      frames, count, grids));
+        assert(r == linear[i]);
+    }
+    double btime = b.delta();
+
+    printf("%4d frames on %d workspaces, %d placements: "
+           "linear %.3f, grid %.3f ms\n",
+           count, workspaces, windows, atime, btime);
+    delete[] frames;
+    delete[] grids;
+    delete[] linear;
+    delete[] sizes;
+}
+
+int main() {
+    srand(1);
+    test_basic();
+    test_random();
+    bench(300, 1, 3);
+    bench(300, 6, 10);
+    bench(1500, 30, 30);
+    return 0;
+}
+
+// vim: set sw=4 ts=4 et:
@@ -0,0 +1,84 @@
+/*
+ * Count the X requests of a repaint.
+ *
+ * Paints a pixmap a number of times, first with a GC which is created
+ * and freed for every repaint, as Graphics did without its GC pool,
+ * then with Graphics. Each repaint fills, tiles and outlines the pixmap.
+ * Reports the requests and the time per repaint for both.
+ *
+ * usage: testpaint [repaints]
+ */
+#include "config.h"
+#include "ypaint.h"
+#include "yxapp.h"
+#include "ypixmap.h"
+#include "ylocale.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+char const *ApplicationName = "testpaint";
+
+static double now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static void report(const char* name, int count,
+                   unsigned long requests, double millis)
+{
+    printf("%-10s %6.2f requests, %7.3f ms per repaint\n",
+           name, double(requests) / count, millis / count);
+}
+
+int main(int argc, char **argv) {
+    YLocale locale;
+    YXApplication app(&argc, &argv);
+    Display* dpy = app.display();
+
+    const int count = (argc > 1) ? max(1, atoi(argv[1])) : 1000;
+    const unsigned w = 200, h = 20, depth = app.depth();
+    Pixmap pixmap = XCreatePixmap(dpy, app.root(), w, h, depth);
+    Pixmap tile = XCreatePixmap(dpy, app.root(), 8, h, depth);
+    XSync(dpy, False);
+
+    unsigned long start = NextRequest(dpy);
+    double begin = now();
+    for (int i = 0; i < count; ++i) {
+        XGCValues gcv;
+        gcv.graphics_exposures = False;
+        GC gc = XCreateGC(dpy, pixmap, GCGraphicsExposures, &gcv);
+        XSetForeground(dpy, gc, app.white());
+        XFillRectangle(dpy, pixmap, gc, 0, 0, w, h);
+        XSetTile(dpy, gc, tile);
+        XSetTSOrigin(dpy, gc, 0, 0);
+        XSetFillStyle(dpy, gc, FillTiled);
+        XFillRectangle(dpy, pixmap, gc, 0, 0, w, h);
+        XSetFillStyle(dpy, gc, FillSolid);
+        XSetForeground(dpy, gc, app.black());
+        XDrawRectangle(dpy, pixmap, gc, 0, 0, w - 1, h - 1);
+        XFreeGC(dpy, gc);
+    }
+    XSync(dpy, False);
+    report("unpooled", count, NextRequest(dpy) - start - 1, now() - begin);
+
+    start = NextRequest(dpy);
+    begin = now();
+    for (int i = 0; i < count; ++i) {
+        Graphics g(pixmap, w, h, depth);
+        g.setColorPixel(app.white());
+        g.fillRect(0, 0, w, h);
+        g.repHorz(tile, 8, h, 0, 0, w);
+        g.setColorPixel(app.black());
+        g.drawRect(0, 0, w - 1, h - 1);
+    }
+    XSync(dpy, False);
+    report("pooled", count, NextRequest(dpy) - start - 1, now() - begin);
+
+    XFreePixmap(dpy, tile);
+    XFreePixmap(dpy, pixmap);
+    return 0;
+}
+
+// vim: set sw=4 ts=4 et:
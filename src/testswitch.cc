@@ -0,0 +1,156 @@
+/*
+ * Measure the latency of workspace switches.
+ *
+ * Creates a number of windows on each of two workspaces, then switches
+ * between them via _NET_CURRENT_DESKTOP. For each switch it reports the
+ * time until the window manager announced the new workspace and until
+ * every window on it received its first expose.
+ *
+ * usage: testswitch [windows-per-workspace [switches]]
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/select.h>
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+static Display *display = 0;
+static Window root = None;
+static Atom currentDesktop, wmDesktop;
+
+static double now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static bool waitEvent(XEvent *xev, double deadline) {
+    while (XPending(display) == 0) {
+        double left = deadline - now();
+        if (left <= 0)
+            return false;
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(ConnectionNumber(display), &fds);
+        timeval tv = { long(left / 1e3), long(left * 1e3) % 1000000L };
+        select(ConnectionNumber(display) + 1, &fds, 0, 0, &tv);
+    }
+    XNextEvent(display, xev);
+    return true;
+}
+
+static void switchTo(long workspace) {
+    XClientMessageEvent msg;
+    memset(&msg, 0, sizeof msg);
+    msg.type = ClientMessage;
+    msg.window = root;
+    msg.message_type = currentDesktop;
+    msg.format = 32;
+    msg.data.l[0] = workspace;
+    msg.data.l[1] = CurrentTime;
+    XSendEvent(display, root, False,
+               SubstructureNotifyMask | SubstructureRedirectMask,
+               (XEvent *) &msg);
+    XFlush(display);
+}
+
+int main(int argc, char **argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 50;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    assert(count > 0 && rounds > 0);
+
+    assert((display = XOpenDisplay(0)) != 0);
+    root = DefaultRootWindow(display);
+    currentDesktop = XInternAtom(display, "_NET_CURRENT_DESKTOP", False);
+    wmDesktop = XInternAtom(display, "_NET_WM_DESKTOP", False);
+    XSelectInput(display, root, PropertyChangeMask);
+
+    Window *windows = new Window[2 * count];
+    bool *exposed = new bool[2 * count];
+    int sw = DisplayWidth(display, DefaultScreen(display));
+    int sh = DisplayHeight(display, DefaultScreen(display));
+
+    for (int i = 0; i < 2 * count; i++) {
+        XSetWindowAttributes attr;
+        attr.background_pixel = (i * 0x2468ACUL) & 0xFFFFFF;
+        attr.event_mask = ExposureMask;
+        windows[i] = XCreateWindow(display, root,
+                                   (i * 37) % (sw / 2), (i * 23) % (sh / 2),
+                                   sw / 3, sh / 3, 0,
+                                   CopyFromParent, InputOutput,
+                                   CopyFromParent,
+                                   CWBackPixel | CWEventMask, &attr);
+        long workspace = i / count;
+        XChangeProperty(display, windows[i], wmDesktop, XA_CARDINAL, 32,
+                        PropModeReplace, (unsigned char *) &workspace, 1);
+        XMapWindow(display, windows[i]);
+    }
+
+    switchTo(0);
+    XSync(display, False);
+    XEvent xev;
+    while (waitEvent(&xev, now() + 500))
+        ;
+
+    double propSum = 0, propMax = 0, exposeSum = 0, exposeMax = 0;
+    int exposeRounds = 0;
+    for (int r = 1; r <= rounds; r++) {
+        long workspace = r % 2;
+        int pending = count;
+        double prop = -1, expose = -1;
+        memset(exposed, 0, 2 * count * sizeof(bool));
+
+        double start = now();
+        switchTo(workspace);
+        while ((prop < 0 || pending > 0) && waitEvent(&xev, start + 2000)) {
+            if (xev.type == PropertyNotify &&
+                xev.xproperty.atom == currentDesktop && prop < 0)
+            {
+                prop = now() - start;
+            }
+            else if (xev.type == Expose) {
+                for (int i = workspace * count; i < (workspace + 1) * count; i++) {
+                    if (windows[i] == xev.xexpose.window && !exposed[i]) {
+                        exposed[i] = true;
+                        if (--pending == 0)
+                            expose = now() - start;
+                    }
+                }
+            }
+        }
+        if (prop < 0) {
+            fprintf(stderr, "no workspace switch after 2 seconds\n");
+            return 1;
+        }
+        propSum += prop;
+        if (propMax < prop)
+            propMax = prop;
+        if (expose >= 0) {
+            exposeSum += expose;
+            if (exposeMax < expose)
+                exposeMax = expose;
+            exposeRounds++;
+        }
+    }
+
+    printf("%d switches with %d windows per workspace\n", rounds, count);
+    printf("  announced: avg %.2f ms, max %.2f ms\n",
+           propSum / rounds, propMax);
+    if (exposeRounds)
+        printf("  exposed:   avg %.2f ms, max %.2f ms (%d switches)\n",
+               exposeSum / exposeRounds, exposeMax, exposeRounds);
+    else
+        printf("  exposed:   no complete exposures (compositing?)\n");
+
+    delete[] windows;
+    delete[] exposed;
+    XCloseDisplay(display);
+    return 0;
+}
+
+// vim: set sw=4 ts=4 et:
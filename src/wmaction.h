@@ -14,6 +14,7 @@ enum WMAction {
     ICEWM_ACTION_SUSPEND = 9,
     ICEWM_ACTION_WINOPTIONS = 10,
     ICEWM_ACTION_RELOADKEYS = 11,
+    ICEWM_ACTION_EVENTSTATS = 12,
 };
 
 enum RebootShutdown {
@@ -654,6 +654,7 @@ void YWMApp::restartClient(const char *cpath, char *const *cargs) {
     char *const *args = (cargs == nullptr) ? nullptr : sargs.getCArray();
 
     wmapp->signalGuiEvent(geRestart);
+    manager->saveRestartState();
     manager->unmanageClients();
     unregisterProtocols();
 
@@ -913,6 +914,8 @@ void YWMApp::actionPerformed(YAction action, unsigned int /*modifiers*/) {
         if (manager && !initializing) {
             if (manager->wmState() == YWindowManager::wmRUNNING) {
                 manager->grabKeys();
+            } else {
+                manager->updateKeys();
             }
         }
     } else if (action == actionCollapseTaskbar && taskBar) {
@@ -1143,9 +1146,11 @@ YWMApp::YWMApp(int *argc, char ***argv, const char *displayName,
 {
     wmapp = this;
 
+    YTracePhase phase("configuration");
     WMConfig::loadConfiguration(this, configFile);
     if (themeName != nullptr) {
         MSG(("themeName=%s", themeName));
+        phase.init("theme");
 
         bool ok = WMConfig::loadThemeConfiguration(this, themeName);
         if (ok == false && strcmp(themeName, CONFIG_DEFAULT_THEME)) {
@@ -1157,6 +1162,7 @@ YWMApp::YWMApp(int *argc, char ***argv, const char *displayName,
             ok = WMConfig::loadThemeConfiguration(this, themeName);
         }
     }
+    phase.init("prefoverride");
     loadFocusMode();
     WMConfig::loadConfiguration(this, "prefoverride");
     if (focusMode != FocusCustom)
@@ -1182,9 +1188,12 @@ YWMApp::YWMApp(int *argc, char ***argv, const char *displayName,
     catchSignal(SIGUSR2);
     catchSignal(SIGPIPE);
 
+    phase.init("winoptions");
     actionPerformed(actionWinOptions, 0);
+    phase.init("keys");
     actionPerformed(actionReloadKeys, 0);
 
+    phase.init("pointers");
     initPointers();
 
     if (post_preferences)
@@ -1194,6 +1203,7 @@ YWMApp::YWMApp(int *argc, char ***argv, const char *displayName,
 
     delete desktop;
 
+    phase.init("manager");
     managerWindow = registerProtocols1(*argv, *argc);
 
     manager = new YWindowManager(
@@ -1202,8 +1212,10 @@ YWMApp::YWMApp(int *argc, char ***argv, const char *displayName,
 
     registerProtocols2(managerWindow);
 
+    phase.init("icons");
     initIcons();
     initIconSize();
+    phase.init("pixmaps");
     WPixRes::initPixmaps();
 
     if (scrollBarWidth == 0) {
@@ -1256,10 +1268,13 @@ YWMApp::YWMApp(int *argc, char ***argv, const char *displayName,
         }
     }
 
+    phase.init("workspaces");
     manager->initWorkspaces();
 
+    phase.init("grabKeys");
     manager->grabKeys();
 
+    phase.init("rootProxy");
     manager->setupRootProxy();
 
 #ifdef CONFIG_SESSION
@@ -1318,7 +1333,9 @@ YWMApp::~YWMApp() {
 
 int YWMApp::mainLoop() {
     signalGuiEvent(geStartup);
+    YTracePhase phase("manageClients");
     manager->manageClients();
+    phase.done();
 
     if (notifyParent) {
         notifiedParent = getppid();
@@ -1366,7 +1383,14 @@ bool YWMApp::handleIdle() {
     static int qbits;
     bool busy = YSMApplication::handleIdle();
 
-    if ((QLength(display()) >> qbits) > 0) {
+    if (manager->containing())
+        manager->updateContainers();
+    manager->flushRestack();
+    manager->flushClientList();
+    // the loop may sleep next: don't leave the deferred requests buffered
+    XFlush(display());
+
+    if ((pendingEvents() >> qbits) > 0) {
         ++qbits;
     }
     else if (taskBar == nullptr && showTaskBar) {
@@ -1414,6 +1438,12 @@ void YWMApp::signalGuiEvent(GUIEvent ge) {
 }
 
 bool YWMApp::filterEvent(const XEvent &xev) {
+    if (xev.type == MappingNotify) {
+        YSMApplication::filterEvent(xev);
+        if (manager)
+            manager->regrabMouse();
+        return true;
+    }
     if (xev.type == SelectionClear) {
         if (xev.xselectionclear.window == managerWindow) {
             manager->unmanageClients();
@@ -1707,6 +1737,7 @@ int main(int argc, char **argv) {
     if (restart_wm)
         return restartWM(displayName, overrideTheme);
 
+    YTracePhase phase("preferences");
     if (isEmpty(configFile))
         configFile = "preferences";
     loadStartup(configFile);
@@ -1717,9 +1748,11 @@ int main(int argc, char **argv) {
     if (loggingEvents)
         initLogEvents();
 
+    phase.init("application");
     YWMApp app(&argc, &argv, displayName,
                 notify_parent, splashFile,
                 configFile, overrideTheme);
+    phase.done();
 
     int rc = app.mainLoop();
     app.signalGuiEvent(geShutdown);
@@ -1734,11 +1767,13 @@ int main(int argc, char **argv) {
 
 void YWMApp::createTaskBar() {
     if (showTaskBar && taskBar == nullptr) {
+        YTracePhase phase("taskbar");
         manager->lockWorkArea();
         taskBar = new TaskBar(this, desktop, this, this);
         for (YFrameIter frame = manager->focusedIterator(); ++frame; ) {
             frame->updateTaskBar();
         }
+        manager->restoreTaskOrder();
         taskBar->showBar();
         taskBar->relayoutNow();
         manager->unlockWorkArea();
@@ -1845,6 +1880,9 @@ void YWMApp::handleSMAction(WMAction message) {
     case ICEWM_ACTION_RELOADKEYS:
         wmapp->actionPerformed(actionReloadKeys, 0);
         break;
+    case ICEWM_ACTION_EVENTSTATS:
+        wmapp->eventStatistics();
+        break;
     }
 }
 
@@ -16,6 +16,13 @@
 #include "yxcontext.h"
 #include "workspaces.h"
 
+// property sizes in 32-bit units, as in Xlib's Xatomtype.h
+enum {
+    NumPropSizeElements = 18,
+    OldNumPropSizeElements = 15,
+    NumPropWMHintsElements = 9,
+};
+
 bool operator==(const XSizeHints& a, const XSizeHints& b) {
     long mask = PMinSize | PMaxSize | PResizeInc |
                 PAspect | PBaseSize | PWinGravity;
@@ -119,33 +126,54 @@ void YFrameClient::getProtocols(bool force) {
     if (!prop.wm_protocols && !force)
         return;
 
-    Atom *wmp = nullptr;
-    int count = 0;
-
     fProtocols &= wpDeleteWindow; // always keep WM_DELETE_WINDOW
 
-    if (XGetWMProtocols(xapp->display(), handle(), &wmp, &count) && wmp) {
+    YProperty wmp(this, _XA_WM_PROTOCOLS, F32, 32, XA_ATOM);
+    if (wmp) {
         prop.wm_protocols = true;
-        for (int i = 0; i < count; i++) {
+        for (unsigned long i = 0; i < wmp.size(); i++) {
             fProtocols |=
-                (wmp[i] == _XA_WM_DELETE_WINDOW) ? wpDeleteWindow :
-                (wmp[i] == _XA_WM_TAKE_FOCUS) ? wpTakeFocus :
-                (wmp[i] == _XA_NET_WM_PING) ? wpPing :
+                (Atom(wmp[i]) == _XA_WM_DELETE_WINDOW) ? wpDeleteWindow :
+                (Atom(wmp[i]) == _XA_WM_TAKE_FOCUS) ? wpTakeFocus :
+                (Atom(wmp[i]) == _XA_NET_WM_PING) ? wpPing :
                 0;
         }
-        XFree(wmp);
     }
 }
 
 void YFrameClient::getSizeHints() {
     if (fSizeHints) {
-        long supplied;
-
-        if (!prop.wm_normal_hints ||
-            !XGetWMNormalHints(xapp->display(),
-                               handle(),
-                               fSizeHints, &supplied))
-            fSizeHints->flags = 0;
+        fSizeHints->flags = 0;
+
+        // decode as XGetWMNormalHints does
+        if (prop.wm_normal_hints) {
+            YProperty normal(this, XA_WM_NORMAL_HINTS, F32,
+                             NumPropSizeElements, XA_WM_SIZE_HINTS);
+            if (normal && normal.size() >= OldNumPropSizeElements) {
+                long supplied = USPosition | USSize | PAllHints;
+                fSizeHints->x = int(normal[1]);
+                fSizeHints->y = int(normal[2]);
+                fSizeHints->width = int(normal[3]);
+                fSizeHints->height = int(normal[4]);
+                fSizeHints->min_width = int(normal[5]);
+                fSizeHints->min_height = int(normal[6]);
+                fSizeHints->max_width = int(normal[7]);
+                fSizeHints->max_height = int(normal[8]);
+                fSizeHints->width_inc = int(normal[9]);
+                fSizeHints->height_inc = int(normal[10]);
+                fSizeHints->min_aspect.x = int(normal[11]);
+                fSizeHints->min_aspect.y = int(normal[12]);
+                fSizeHints->max_aspect.x = int(normal[13]);
+                fSizeHints->max_aspect.y = int(normal[14]);
+                if (normal.size() >= NumPropSizeElements) {
+                    supplied |= PBaseSize | PWinGravity;
+                    fSizeHints->base_width = int(normal[15]);
+                    fSizeHints->base_height = int(normal[16]);
+                    fSizeHints->win_gravity = int(normal[17]);
+                }
+                fSizeHints->flags = normal[0] & supplied;
+            }
+        }
 
         if (fSizeHints->flags & PResizeInc) {
             if (fSizeHints->width_inc == 0) fSizeHints->width_inc = 1;
@@ -191,7 +219,17 @@ void YFrameClient::getClassHint() {
         return;
 
     fClassHint.reset();
-    XGetClassHint(xapp->display(), handle(), &fClassHint);
+
+    // decode as XGetClassHint does
+    YProperty names(this, XA_WM_CLASS, F8, BUFSIZ, XA_STRING);
+    if (names) {
+        const char* name = names.data<char>();
+        size_t length = strlen(name);
+        if (length == names.size())
+            length--;
+        fClassHint.res_name = strdup(name);
+        fClassHint.res_class = strdup(name + length + 1);
+    }
 }
 
 void YFrameClient::getTransient() {
@@ -200,10 +238,9 @@ void YFrameClient::getTransient() {
 
     Window newTransientFor = 0;
 
-    if (XGetTransientForHint(xapp->display(),
-                             handle(),
-                             &newTransientFor))
-    {
+    YProperty transient(this, XA_WM_TRANSIENT_FOR, F32, 1, XA_WINDOW);
+    if (transient) {
+        newTransientFor = Window(*transient);
         if (//newTransientFor == desktop->handle() || /* bug in xfm */
             //newTransientFor == desktop->handle() ||
             newTransientFor == handle()             /* bug in fdesign */
@@ -471,17 +508,17 @@ void YFrameClient::setFrameState(FrameState state) {
     if (state == WithdrawnState) {
         if (manager->wmState() != YWindowManager::wmSHUTDOWN) {
             MSG(("deleting window properties id=%lX", handle()));
-            XDeleteProperty(xapp->display(), handle(), _XA_NET_FRAME_EXTENTS);
-            XDeleteProperty(xapp->display(), handle(), _XA_NET_WM_VISIBLE_NAME);
-            XDeleteProperty(xapp->display(), handle(), _XA_NET_WM_VISIBLE_ICON_NAME);
-            XDeleteProperty(xapp->display(), handle(), _XA_NET_WM_DESKTOP);
-            XDeleteProperty(xapp->display(), handle(), _XA_NET_WM_STATE);
-            XDeleteProperty(xapp->display(), handle(), _XA_NET_WM_ALLOWED_ACTIONS);
-            XDeleteProperty(xapp->display(), handle(), _XA_WIN_WORKSPACE);
-            XDeleteProperty(xapp->display(), handle(), _XA_WIN_LAYER);
-            XDeleteProperty(xapp->display(), handle(), _XA_WIN_TRAY);
-            XDeleteProperty(xapp->display(), handle(), _XA_WIN_STATE);
-            XDeleteProperty(xapp->display(), handle(), _XA_WM_STATE);
+            deleteProperty(_XA_NET_FRAME_EXTENTS);
+            deleteProperty(_XA_NET_WM_VISIBLE_NAME);
+            deleteProperty(_XA_NET_WM_VISIBLE_ICON_NAME);
+            deleteProperty(_XA_NET_WM_DESKTOP);
+            deleteProperty(_XA_NET_WM_STATE);
+            deleteProperty(_XA_NET_WM_ALLOWED_ACTIONS);
+            deleteProperty(_XA_WIN_WORKSPACE);
+            deleteProperty(_XA_WIN_LAYER);
+            deleteProperty(_XA_WIN_TRAY);
+            deleteProperty(_XA_WIN_STATE);
+            deleteProperty(_XA_WM_STATE);
             fSavedFrameState = InvalidFrameState;
             fSavedWinState[0] = fSavedWinState[1] = 0;
         }
@@ -516,8 +553,7 @@ void YFrameClient::handleUnmap(const XUnmapEvent &unmap) {
     bool destroy = false;
     do {
         XEvent ev;
-        if (XCheckTypedWindowEvent(xapp->display(), unmap.window,
-                                   DestroyNotify, &ev)) {
+        if (xapp->checkWindowEvent(unmap.window, DestroyNotify, &ev)) {
             YWindow::handleDestroyWindow(ev.xdestroywindow);
             manager->destroyedClient(unmap.window);
             unmanage = false;
@@ -746,14 +782,9 @@ void YFrameClient::setWindowTitle(const char *title) {
     if (fWindowTitle != title) {
         fWindowTitle = title;
         if (title) {
-            XChangeProperty(xapp->display(), handle(),
-                    _XA_NET_WM_VISIBLE_NAME, _XA_UTF8_STRING,
-                    8, PropModeReplace,
-                    (const unsigned char *) title,
-                    strlen(title));
+            setTextProperty(_XA_NET_WM_VISIBLE_NAME, _XA_UTF8_STRING, title);
         } else {
-            XDeleteProperty(xapp->display(), handle(),
-                    _XA_NET_WM_VISIBLE_NAME);
+            deleteProperty(_XA_NET_WM_VISIBLE_NAME);
         }
         if (getFrame())
             getFrame()->updateTitle();
@@ -764,14 +795,9 @@ void YFrameClient::setIconTitle(const char *title) {
     if (fIconTitle != title) {
         fIconTitle = title;
         if (title) {
-            XChangeProperty(xapp->display(), handle(),
-                    _XA_NET_WM_VISIBLE_ICON_NAME, _XA_UTF8_STRING,
-                    8, PropModeReplace,
-                    (const unsigned char *) title,
-                    strlen(title));
+            setTextProperty(_XA_NET_WM_VISIBLE_ICON_NAME, _XA_UTF8_STRING, title);
         } else {
-            XDeleteProperty(xapp->display(), handle(),
-                    _XA_NET_WM_VISIBLE_ICON_NAME);
+            deleteProperty(_XA_NET_WM_VISIBLE_ICON_NAME);
         }
         if (getFrame())
             getFrame()->updateIconTitle();
@@ -966,20 +992,16 @@ void YFrameClient::getNameHint() {
     if (prop.net_wm_name)
         return;
 
-    XTextProperty text = { nullptr, None, 0, 0 };
-    XGetWMName(xapp->display(), handle(), &text);
-    setWindowTitle((char *)text.value);
-    XFree(text.value);
+    YProperty text(this, XA_WM_NAME, F8, BUFSIZ);
+    setWindowTitle(text.data<char>());
 }
 
 void YFrameClient::getNetWmName() {
     if (!prop.net_wm_name)
         return;
 
-    XTextProperty text = { nullptr, None, 0, 0 };
-    XGetTextProperty(xapp->display(), handle(), &text, _XA_NET_WM_NAME);
-    setWindowTitle((char *)text.value);
-    XFree(text.value);
+    YProperty text(this, _XA_NET_WM_NAME, F8, BUFSIZ);
+    setWindowTitle(text.data<char>());
 }
 
 void YFrameClient::getIconNameHint() {
@@ -988,29 +1010,44 @@ void YFrameClient::getIconNameHint() {
     if (prop.net_wm_icon_name)
         return;
 
-    XTextProperty text = { nullptr, None, 0, 0 };
-    XGetWMIconName(xapp->display(), handle(), &text);
-    setIconTitle((char *)text.value);
-    XFree(text.value);
+    YProperty text(this, XA_WM_ICON_NAME, F8, BUFSIZ);
+    setIconTitle(text.data<char>());
 }
 
 void YFrameClient::getNetWmIconName() {
     if (!prop.net_wm_icon_name)
         return;
 
-    XTextProperty text = { nullptr, None, 0, 0 };
-    XGetTextProperty(xapp->display(), handle(), &text, _XA_NET_WM_ICON_NAME);
-    setIconTitle((char *)text.value);
-    XFree(text.value);
+    YProperty text(this, _XA_NET_WM_ICON_NAME, F8, BUFSIZ);
+    setIconTitle(text.data<char>());
 }
 
 void YFrameClient::getWMHints() {
     if (!prop.wm_hints)
         return;
 
-    if (fHints)
+    if (fHints) {
         XFree(fHints);
-    fHints = XGetWMHints(xapp->display(), handle());
+        fHints = nullptr;
+    }
+
+    // decode as XGetWMHints does
+    YProperty hints(this, XA_WM_HINTS, F32, NumPropWMHintsElements,
+                    XA_WM_HINTS);
+    if (hints && hints.size() >= NumPropWMHintsElements - 1 &&
+        (fHints = XAllocWMHints()) != nullptr)
+    {
+        fHints->flags = hints[0];
+        fHints->input = hints[1] ? True : False;
+        fHints->initial_state = int(hints[2]);
+        fHints->icon_pixmap = Pixmap(hints[3]);
+        fHints->icon_window = Window(hints[4]);
+        fHints->icon_x = int(hints[5]);
+        fHints->icon_y = int(hints[6]);
+        fHints->icon_mask = Pixmap(hints[7]);
+        fHints->window_group = hints.size() >= NumPropWMHintsElements
+                             ? XID(hints[8]) : None;
+    }
 }
 
 void YFrameClient::getMwmHints() {
@@ -1410,9 +1447,9 @@ bool YFrameClient::getNetStartupId(unsigned long &time) {
     if (!prop.net_startup_id)
         return false;
 
-    YTextProperty id(nullptr);
-    if (XGetTextProperty(xapp->display(), handle(), &id, _XA_NET_STARTUP_ID)) {
-        char* str = strstr((char *)id.value, "_TIME");
+    YProperty id(this, _XA_NET_STARTUP_ID, F8, BUFSIZ);
+    if (id) {
+        char* str = strstr(id.data<char>(), "_TIME");
         if (str) {
             time = atol(str + 5) & 0xffffffff;
             if (time == -1UL)
@@ -1523,7 +1560,7 @@ void YFrameClient::getPropertiesList() {
 
     memset(&prop, 0, sizeof(prop));
 
-    p = XListProperties(xapp->display(), handle(), &count);
+    p = listProperties(handle(), &count);
 
 #define HAS(x)   ((x) = true)
 
@@ -8,6 +8,7 @@
 #include "config.h"
 #include "wmdialog.h"
 #include "wpixmaps.h"
+#include "wpixres.h"
 #include "prefs.h"
 #include "wmapp.h"
 #include "wmmgr.h"
@@ -53,6 +54,7 @@ bool canShutdown(RebootShutdown reboot) {
 
 CtrlAltDelete::CtrlAltDelete(IApp *app, YWindow *parent): YWindow(parent) {
     this->app = app;
+    WPixRes::initPixmaps(WPixRes::pgLogout);
     unsigned w = 140, h = 22;
 
     setStyle(wsOverrideRedirect);
@@ -115,6 +115,9 @@ YFrameWindow::YFrameWindow(
     fWinActiveLayer = WinLayerNormal;
     fWinRequestedLayer = WinLayerNormal;
     fOldLayer = fWinActiveLayer;
+    fStackRank = 0;
+    fFocusStamp = 0;
+    manager->indexFrame(this);
     fWinTrayOption = WinTrayIgnore;
     fWinState = 0;
     fWinOptionMask = ~0;
@@ -170,6 +173,7 @@ YFrameWindow::~YFrameWindow() {
     manager->removeClientFrame(this);
     manager->removeCreatedFrame(this);
     removeFrame();
+    manager->unindexFrame(this);
     if (wmapp->hasSwitchWindow())
         wmapp->getSwitchWindow()->destroyedFrame(this);
     if (fClient != nullptr) {
@@ -429,8 +433,6 @@ void YFrameWindow::afterManage() {
         manager->updateWorkArea();
     manager->updateClientList();
     setShape();
-    if ( !frameOption(foFullKeys))
-        grabKeys();
     fClientContainer->grabButtons();
     addToWindowList();
     if (fWindowType == wtDialog)
@@ -481,48 +483,6 @@ void YFrameWindow::createPointerWindows() {
     container()->raise();
 }
 
-void YFrameWindow::grabKeys() {
-    XUngrabKey(xapp->display(), AnyKey, AnyModifier, handle());
-
-    GRAB_WMKEY(gKeyWinRaise);
-    GRAB_WMKEY(gKeyWinOccupyAll);
-    GRAB_WMKEY(gKeyWinLower);
-    GRAB_WMKEY(gKeyWinClose);
-    GRAB_WMKEY(gKeyWinRestore);
-    GRAB_WMKEY(gKeyWinNext);
-    GRAB_WMKEY(gKeyWinPrev);
-    GRAB_WMKEY(gKeyWinMove);
-    GRAB_WMKEY(gKeyWinSize);
-    GRAB_WMKEY(gKeyWinMinimize);
-    GRAB_WMKEY(gKeyWinMaximize);
-    GRAB_WMKEY(gKeyWinMaximizeVert);
-    GRAB_WMKEY(gKeyWinMaximizeHoriz);
-    GRAB_WMKEY(gKeyWinHide);
-    GRAB_WMKEY(gKeyWinRollup);
-    GRAB_WMKEY(gKeyWinFullscreen);
-    GRAB_WMKEY(gKeyWinMenu);
-    GRAB_WMKEY(gKeyWinArrangeN);
-    GRAB_WMKEY(gKeyWinArrangeNE);
-    GRAB_WMKEY(gKeyWinArrangeE);
-    GRAB_WMKEY(gKeyWinArrangeSE);
-    GRAB_WMKEY(gKeyWinArrangeS);
-    GRAB_WMKEY(gKeyWinArrangeSW);
-    GRAB_WMKEY(gKeyWinArrangeW);
-    GRAB_WMKEY(gKeyWinArrangeNW);
-    GRAB_WMKEY(gKeyWinArrangeC);
-    GRAB_WMKEY(gKeyWinSnapMoveN);
-    GRAB_WMKEY(gKeyWinSnapMoveNE);
-    GRAB_WMKEY(gKeyWinSnapMoveE);
-    GRAB_WMKEY(gKeyWinSnapMoveSE);
-    GRAB_WMKEY(gKeyWinSnapMoveS);
-    GRAB_WMKEY(gKeyWinSnapMoveSW);
-    GRAB_WMKEY(gKeyWinSnapMoveW);
-    GRAB_WMKEY(gKeyWinSnapMoveNW);
-    GRAB_WMKEY(gKeyWinSmartPlace);
-
-    container()->regrabMouse();
-}
-
 void YFrameWindow::manage() {
     PRECONDITION(client());
 
@@ -702,12 +662,12 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
         switch (configureRequest.detail + (sibling ? 5 : 0)) {
         case 5 + Above:
             if (setAbove(sibling)) {
-                raiseTo(sibling);
+                restack();
             }
             break;
         case 5 + Below:
             if (setBelow(sibling)) {
-                beneath(sibling);
+                restack();
             }
             break;
         case 5 + TopIf:
@@ -715,7 +675,7 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
                 for (YFrameWindow* f = prev(); f; f = f->prev()) {
                     if (f == sibling) {
                         if (overlap(sibling) && setAbove(sibling)) {
-                            raiseTo(sibling);
+                            restack();
                         }
                         break;
                     }
@@ -728,7 +688,7 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
                 for (f = next(); f && f != owner(); f = f->next()) {
                     if (f == sibling) {
                         if (overlap(sibling) && setBelow(sibling)) {
-                            beneath(sibling);
+                            restack();
                         }
                         break;
                     }
@@ -741,7 +701,7 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
                 for (YFrameWindow* f = prev(); f; f = f->prev()) {
                     if (f == sibling) {
                         if (overlap(sibling) && setAbove(sibling)) {
-                            raiseTo(sibling);
+                            restack();
                         }
                         search = false;
                         break;
@@ -752,7 +712,7 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
                     for (f = next(); f && f != owner(); f = f->next()) {
                         if (f == sibling) {
                             if (overlap(sibling) && setBelow(sibling)) {
-                                beneath(sibling);
+                                restack();
                             }
                             break;
                         }
@@ -788,7 +748,7 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
         case Below:
             if (owner() && getActiveLayer() == owner()->getActiveLayer()) {
                 if (setAbove(owner())) {
-                    raiseTo(owner());
+                    restack();
                 }
             }
             else if (focused()) {
@@ -805,7 +765,7 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
                         f = f->prev();
                     }
                     if (setAbove(f)) {
-                        raiseTo(f);
+                        restack();
                     }
                     break;
                 }
@@ -818,7 +778,7 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
                         f = f->next();
                     }
                     if (setBelow(f)) {
-                        beneath(f);
+                        restack();
                     }
                     break;
                 }
@@ -833,7 +793,7 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
                                 f = f->next();
                             }
                             if (setBelow(f)) {
-                                beneath(f);
+                                restack();
                             }
                             break;
                         }
@@ -845,7 +805,7 @@ void YFrameWindow::configureClient(const XConfigureRequestEvent &configureReques
                         f = f->prev();
                     }
                     if (setAbove(f)) {
-                        raiseTo(f);
+                        restack();
                     }
                     break;
                 }
@@ -910,7 +870,7 @@ void YFrameWindow::handleCrossing(const XCrossingEvent &crossing) {
 //        fMouseFocusX = crossing.x_root;
 //        fMouseFocusY = crossing.y_root;
 
-        if (!clickFocus && visible() && canFocusByMouse()) {
+        if (!clickFocus && shownNow() && canFocusByMouse()) {
             if (!delayPointerFocus)
                 focus(false);
             else {
@@ -987,14 +947,14 @@ bool YFrameWindow::handleTimer(YTimer *t) {
 void YFrameWindow::raise() {
     if (this != manager->top(getActiveLayer())) {
         setAbove(manager->top(getActiveLayer()));
-        raiseTo(prevLayer());
+        restack();
     }
 }
 
 void YFrameWindow::lower() {
     if (this != manager->bottom(getActiveLayer())) {
         setAbove(nullptr);
-        beneath(nextLayer());
+        restack();
     }
 }
 
@@ -1022,6 +982,13 @@ void YFrameWindow::insertFrame(bool top) {
 #endif
 }
 
+void YFrameWindow::restack() {
+    if (manager->containing())
+        manager->restackContained(this);
+    else
+        manager->restackWindows();
+}
+
 bool YFrameWindow::setAbove(YFrameWindow *aboveFrame) {
     return manager->setAbove(this, aboveFrame);
 }
@@ -1041,7 +1008,7 @@ YFrameWindow *YFrameWindow::findWindow(int flags) {
             goto next;
         if ((flags & fwfUnminimized) && p->isMinimized())
             goto next;
-        if ((flags & fwfVisible) && !p->visible())
+        if ((flags & fwfVisible) && !p->shownNow())
             goto next;
         if ((flags & fwfHidden) && !p->isHidden())
             goto next;
@@ -1077,7 +1044,7 @@ YFrameWindow *YFrameWindow::findWindow(int flags) {
 
     if (!(flags & fwfSame))
         return nullptr;
-    if ((flags & fwfVisible) && !p->visible())
+    if ((flags & fwfVisible) && !p->shownNow())
         return nullptr;
     if ((flags & fwfWorkspace) && !p->visibleNow())
         return nullptr;
@@ -1406,7 +1373,7 @@ void YFrameWindow::wmLower() {
 void YFrameWindow::doLower() {
     if (next()) {
         if (manager->setAbove(this, nullptr)) {
-            beneath(prev());
+            restack();
         }
     }
 }
@@ -2607,7 +2574,11 @@ void YFrameWindow::setWorkspace(int workspace) {
                 workspaces[ws].focused = nullptr;
             }
         }
+        int previous = fWinWorkspace;
+        manager->unindexFrame(this);
         fWinWorkspace = workspace;
+        manager->indexFrame(this);
+        manager->refileFocusFrame(this, previous);
         client()->setWinWorkspaceHint(fWinWorkspace);
         updateState();
         if (refocus)
@@ -2701,6 +2672,8 @@ void YFrameWindow::updateLayer(bool restack) {
         removeFrame();
         fWinActiveLayer = newLayer;
         insertFrame(true);
+        if (manager->containing())
+            manager->contain(this);
 
         if (client() && !client()->destroyed())
             client()->setWinLayerHint(fWinActiveLayer);
@@ -2733,6 +2706,8 @@ void YFrameWindow::updateState() {
         return ;
 
     client()->setWinStateHint(WIN_STATE_ALL, fWinState);
+    if (manager->containing())
+        manager->contain(this);
 
     FrameState newState = NormalState;
     bool show_frame = true;
@@ -2747,7 +2722,8 @@ void YFrameWindow::updateState() {
         show_frame = false;
         show_client = false;
         newState = IconicState;
-    } else if (!visibleNow()) {
+    } else if (!visibleNow() && !manager->containing()) {
+        // with containers only the container is unmapped
         show_frame = false;
         show_client = false;
         newState = isMinimized() ? IconicState : NormalState;
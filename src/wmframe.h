@@ -22,7 +22,8 @@ class YFrameWindow:
     public ClientData,
     public YLayeredNode,
     public YCreatedNode,
-    public YFocusedNode
+    public YFocusedNode,
+    public YWorkspaceNode
 {
 public:
     YFrameWindow(YActionListener *wmActionListener,
@@ -39,7 +40,6 @@ public:
 
     Window createPointerWindow(Cursor cursor, int gravity);
     void createPointerWindows();
-    void grabKeys();
 
     void focus(bool canWarp = false);
     void activate(bool canWarp = false, bool curWork = true);
@@ -48,6 +48,7 @@ public:
     virtual void paint(Graphics &g, const YRect &r);
 
     virtual bool handleKey(const XKeyEvent &key);
+    bool handleWinKey(WinKeyAction action);
     virtual void handleButton(const XButtonEvent &button);
     virtual void handleClick(const XButtonEvent &up, int count);
     virtual void handleBeginDrag(const XButtonEvent &down, const XMotionEvent &motion);
@@ -185,6 +186,8 @@ public:
 
     virtual void raise();
     virtual void lower();
+    // the stacking order changed: restack when idle, or in a container
+    void restack();
 
     void popupSystemMenu(YWindow *owner, int x, int y,
                          unsigned int flags,
@@ -356,6 +359,10 @@ public:
     void setWorkspace(int workspace);
     void setWorkspaceHint(long workspace);
     long getActiveLayer() const { return fWinActiveLayer; }
+    int stackRank() const { return fStackRank; }
+    void setStackRank(int rank) { fStackRank = rank; }
+    long focusStamp() const { return fFocusStamp; }
+    void setFocusStamp(long stamp) { fFocusStamp = stamp; }
     void setRequestedLayer(long layer);
     long getRequestedLayer() const { return fWinRequestedLayer; }
     long getTrayOption() const { return fWinTrayOption; }
@@ -391,6 +398,9 @@ public:
         return (isAllWorkspaces() || getWorkspace() == workspace);
     }
     bool visibleNow() const { return visibleOn(manager->activeWorkspace()); }
+    // mapped on the active workspace; with workspace containers
+    // frames on other workspaces are mapped too
+    bool shownNow() const { return visible() && visibleNow(); }
 
     bool isModal();
     bool hasModal();
@@ -496,6 +506,8 @@ private:
     int fWinWorkspace;
     long fWinRequestedLayer;
     long fWinActiveLayer;
+    int fStackRank;
+    long fFocusStamp;
     long fWinTrayOption;
     long fWinState;
     long fWinOptionMask;
@@ -23,8 +23,10 @@
 #include "prefs.h"
 #include "yprefs.h"
 #include "yxcontext.h"
+#include "yprefetch.h"
 #include "workspaces.h"
 #include "ystring.h"
+#include "ytrace.h"
 #include "intl.h"
 #include <wordexp.h>
 
@@ -68,6 +70,7 @@ YWindowManager::YWindowManager(
     fArrangeInfo = nullptr;
     rootProxy = nullptr;
     fWorkArea = nullptr;
+    fSpareWorkArea = nullptr;
     fWorkAreaWorkspaceCount = 0;
     fWorkAreaScreenCount = 0;
     fWorkAreaLock = 0;
@@ -75,7 +78,18 @@ YWindowManager::YWindowManager(
     fFullscreenEnabled = true;
     fCreatedUpdated = true;
     fLayeredUpdated = true;
+    fClientListPending = true;
+    fRestackPending = false;
+    fClientListPublished = false;
+    fStackRanked = false;
+    fFocusStampLow = 0;
+    fFocusStampHigh = 0;
     fDefaultKeyboard = 0;
+#ifdef CONFIG_SHAPE
+    fContaining = workspaceContainers && shapes.supported;
+#else
+    fContaining = false;
+#endif
 
     manager = this;
     desktop = this;
@@ -112,10 +126,8 @@ YWindowManager::YWindowManager(
 }
 
 YWindowManager::~YWindowManager() {
-    if (fWorkArea) {
-        delete [] fWorkArea[0];
-        delete [] fWorkArea;
-    }
+    deleteWorkArea(fWorkArea);
+    deleteWorkArea(fSpareWorkArea);
     delete fTopWin;
     delete rootProxy;
 }
@@ -137,9 +149,133 @@ void YWindowManager::ungrabServer() {
         XUngrabServer(xapp->display());
 }
 
+// the key bindings with their actions in the order of precedence
+static const struct KeyBinding {
+    const WMKey* key;
+    int action;
+} sysKeys[] = {
+    { &gKeySysSwitchNext, skSwitchNext },
+    { &gKeySysSwitchLast, skSwitchLast },
+    { &gKeySysSwitchClass, skSwitchClass },
+    { &gKeySysWinNext, skWinNext },
+    { &gKeySysWinPrev, skWinPrev },
+    { &gKeySysWinMenu, skWinMenu },
+    { &gKeySysDialog, skDialog },
+    { &gKeySysWinListMenu, skWinListMenu },
+    { &gKeySysMenu, skMenu },
+    { &gKeySysWindowList, skWindowList },
+    { &gKeySysWorkspacePrev, skWorkspacePrev },
+    { &gKeySysWorkspaceNext, skWorkspaceNext },
+    { &gKeySysWorkspaceLast, skWorkspaceLast },
+    { &gKeySysWorkspacePrevTakeWin, skWorkspacePrevTakeWin },
+    { &gKeySysWorkspaceNextTakeWin, skWorkspaceNextTakeWin },
+    { &gKeySysWorkspaceLastTakeWin, skWorkspaceLastTakeWin },
+    { &gKeySysWorkspace1, skWorkspace1 + 0 },
+    { &gKeySysWorkspace2, skWorkspace1 + 1 },
+    { &gKeySysWorkspace3, skWorkspace1 + 2 },
+    { &gKeySysWorkspace4, skWorkspace1 + 3 },
+    { &gKeySysWorkspace5, skWorkspace1 + 4 },
+    { &gKeySysWorkspace6, skWorkspace1 + 5 },
+    { &gKeySysWorkspace7, skWorkspace1 + 6 },
+    { &gKeySysWorkspace8, skWorkspace1 + 7 },
+    { &gKeySysWorkspace9, skWorkspace1 + 8 },
+    { &gKeySysWorkspace10, skWorkspace1 + 9 },
+    { &gKeySysWorkspace11, skWorkspace1 + 10 },
+    { &gKeySysWorkspace12, skWorkspace1 + 11 },
+    { &gKeySysWorkspace1TakeWin, skWorkspace1TakeWin + 0 },
+    { &gKeySysWorkspace2TakeWin, skWorkspace1TakeWin + 1 },
+    { &gKeySysWorkspace3TakeWin, skWorkspace1TakeWin + 2 },
+    { &gKeySysWorkspace4TakeWin, skWorkspace1TakeWin + 3 },
+    { &gKeySysWorkspace5TakeWin, skWorkspace1TakeWin + 4 },
+    { &gKeySysWorkspace6TakeWin, skWorkspace1TakeWin + 5 },
+    { &gKeySysWorkspace7TakeWin, skWorkspace1TakeWin + 6 },
+    { &gKeySysWorkspace8TakeWin, skWorkspace1TakeWin + 7 },
+    { &gKeySysWorkspace9TakeWin, skWorkspace1TakeWin + 8 },
+    { &gKeySysWorkspace10TakeWin, skWorkspace1TakeWin + 9 },
+    { &gKeySysWorkspace11TakeWin, skWorkspace1TakeWin + 10 },
+    { &gKeySysWorkspace12TakeWin, skWorkspace1TakeWin + 11 },
+    { &gKeySysTileVertical, skTileVertical },
+    { &gKeySysTileHorizontal, skTileHorizontal },
+    { &gKeySysCascade, skCascade },
+    { &gKeySysArrange, skArrange },
+    { &gKeySysUndoArrange, skUndoArrange },
+    { &gKeySysArrangeIcons, skArrangeIcons },
+    { &gKeySysMinimizeAll, skMinimizeAll },
+    { &gKeySysHideAll, skHideAll },
+    { &gKeySysAddressBar, skAddressBar },
+    { &gKeySysShowDesktop, skShowDesktop },
+    { &gKeySysCollapseTaskBar, skCollapseTaskBar },
+    { &gKeyTaskBarSwitchPrev, skTaskBarSwitchPrev },
+    { &gKeyTaskBarSwitchNext, skTaskBarSwitchNext },
+    { &gKeyTaskBarMovePrev, skTaskBarMovePrev },
+    { &gKeyTaskBarMoveNext, skTaskBarMoveNext },
+}, winKeys[] = {
+    { &gKeyWinClose, wkClose },
+    { &gKeyWinPrev, wkPrev },
+    { &gKeyWinMaximizeVert, wkMaximizeVert },
+    { &gKeyWinMaximizeHoriz, wkMaximizeHoriz },
+    { &gKeyWinRaise, wkRaise },
+    { &gKeyWinOccupyAll, wkOccupyAll },
+    { &gKeyWinLower, wkLower },
+    { &gKeyWinRestore, wkRestore },
+    { &gKeyWinNext, wkNext },
+    { &gKeyWinMove, wkMove },
+    { &gKeyWinSize, wkSize },
+    { &gKeyWinMinimize, wkMinimize },
+    { &gKeyWinMaximize, wkMaximize },
+    { &gKeyWinHide, wkHide },
+    { &gKeyWinRollup, wkRollup },
+    { &gKeyWinFullscreen, wkFullscreen },
+    { &gKeyWinMenu, wkMenu },
+    { &gKeyWinArrangeN, wkArrangeN },
+    { &gKeyWinArrangeNE, wkArrangeNE },
+    { &gKeyWinArrangeE, wkArrangeE },
+    { &gKeyWinArrangeSE, wkArrangeSE },
+    { &gKeyWinArrangeS, wkArrangeS },
+    { &gKeyWinArrangeSW, wkArrangeSW },
+    { &gKeyWinArrangeW, wkArrangeW },
+    { &gKeyWinArrangeNW, wkArrangeNW },
+    { &gKeyWinArrangeC, wkArrangeC },
+    { &gKeyWinSnapMoveN, wkSnapMoveN },
+    { &gKeyWinSnapMoveNE, wkSnapMoveNE },
+    { &gKeyWinSnapMoveE, wkSnapMoveE },
+    { &gKeyWinSnapMoveSE, wkSnapMoveSE },
+    { &gKeyWinSnapMoveS, wkSnapMoveS },
+    { &gKeyWinSnapMoveSW, wkSnapMoveSW },
+    { &gKeyWinSnapMoveW, wkSnapMoveW },
+    { &gKeyWinSnapMoveNW, wkSnapMoveNW },
+    { &gKeyWinSmartPlace, wkSmartPlace },
+};
+
+void YWindowManager::updateKeys() {
+    // the first binding of a key wins and programs come first
+    fSysKeys.clear();
+    for (int i = 0; i < keyProgs.getCount(); ++i) {
+        fSysKeys.add(keyProgs[i]->key(), keyProgs[i]->modifiers(),
+                     skCount + i);
+    }
+    for (unsigned i = quickSwitch ? 0 : 3; i < ACOUNT(sysKeys); ++i) {
+        fSysKeys.add(sysKeys[i].key->key, sysKeys[i].key->mod,
+                     sysKeys[i].action);
+    }
+    fWinKeys.clear();
+    for (unsigned i = 0; i < ACOUNT(winKeys); ++i) {
+        fWinKeys.add(winKeys[i].key->key, winKeys[i].key->mod,
+                     winKeys[i].action);
+    }
+}
+
 void YWindowManager::grabKeys() {
+    updateKeys();
     XUngrabKey(xapp->display(), AnyKey, AnyModifier, handle());
 
+    // window keys are grabbed here for the focused frame, synchronously
+    // to replay them when it wants all keys, before global keys replace
+    // the grabs of identical bindings
+    for (unsigned i = 0; i < ACOUNT(winKeys); ++i) {
+        grabVKey(winKeys[i].key->key, winKeys[i].key->mod, true);
+    }
+
     ///if (taskBar && taskBar->addressBar())
         GRAB_WMKEY(gKeySysAddressBar);
     if (quickSwitch) {
@@ -237,9 +373,11 @@ void YWindowManager::grabKeys() {
             grabButton(5, xapp->WinMask);
         }
     }
+}
 
+void YWindowManager::regrabMouse() {
     for (YFrameWindow *ff = topLayer(); ff; ff = ff->nextLayer()) {
-        ff->grabKeys();
+        ff->container()->regrabMouse();
     }
 }
 
@@ -267,248 +405,177 @@ void YWindowManager::setupRootProxy() {
 
 bool YWindowManager::handleWMKey(const XKeyEvent &key, KeySym k, unsigned int /*m*/, unsigned int vm) {
     YFrameWindow *frame = getFocus();
+    const int action = fSysKeys.find(k, vm);
 
-    KProgramIterType p = keyProgs.iterator();
-    while (++p) {
-        if (!p->isKey(k, vm)) continue;
-
+    if (action >= skCount) {
+        if (action - skCount < keyProgs.getCount()) {
+            XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
+            keyProgs[action - skCount]->open(key.state);
+            return true;
+        }
+        return false;
+    }
+    if (inrange(action, int(skWorkspace1), skWorkspace1 + 11)) {
+        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
+        switchToWorkspace(action - skWorkspace1, false);
+        return true;
+    }
+    if (inrange(action, int(skWorkspace1TakeWin), skWorkspace1TakeWin + 11)) {
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        p->open(key.state);
+        switchToWorkspace(action - skWorkspace1TakeWin, true);
         return true;
     }
 
-    if (wmapp->getSwitchWindow() != nullptr) {
-        if (IS_WMKEY(k, vm, gKeySysSwitchNext)) {
+    switch (action) {
+    case skSwitchNext:
+    case skSwitchLast:
+        if (wmapp->getSwitchWindow() != nullptr) {
             XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-            wmapp->getSwitchWindow()->begin(true, key.state);
+            wmapp->getSwitchWindow()->begin(action == skSwitchNext, key.state);
             return true;
-        } else if (IS_WMKEY(k, vm, gKeySysSwitchLast)) {
-            XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-            wmapp->getSwitchWindow()->begin(false, key.state);
-            return true;
-        } else if (gKeySysSwitchClass.eq(k, vm)) {
+        }
+        break;
+    case skSwitchClass:
+        if (wmapp->getSwitchWindow() != nullptr) {
             char *prop = frame && frame->client()->adopted()
                        ? frame->client()->classHint()->resource() : nullptr;
             XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
             wmapp->getSwitchWindow()->begin(true, key.state, prop);
             return true;
         }
-    }
-    if (IS_WMKEY(k, vm, gKeySysWinNext)) {
+        break;
+    case skWinNext:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         if (frame) frame->wmNextWindow();
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWinPrev)) {
+    case skWinPrev:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         if (frame) frame->wmPrevWindow();
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWinMenu)) {
+    case skWinMenu:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         if (frame) frame->popupSystemMenu(this);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysDialog)) {
+    case skDialog:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         if (wmapp->getCtrlAltDelete()) {
             wmapp->getCtrlAltDelete()->activate();
         }
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWinListMenu)) {
+    case skWinListMenu:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         popupWindowListMenu(this);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysMenu)) {
+    case skMenu:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         popupStartMenu(this);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWindowList)) {
+    case skWindowList:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionWindowList, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspacePrev)) {
+    case skWorkspacePrev:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         switchToPrevWorkspace(false);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspaceNext)) {
+    case skWorkspaceNext:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         switchToNextWorkspace(false);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspaceLast)) {
+    case skWorkspaceLast:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         switchToLastWorkspace(false);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspacePrevTakeWin)) {
+    case skWorkspacePrevTakeWin:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         switchToPrevWorkspace(true);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspaceNextTakeWin)) {
+    case skWorkspaceNextTakeWin:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         switchToNextWorkspace(true);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspaceLastTakeWin)) {
+    case skWorkspaceLastTakeWin:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         switchToLastWorkspace(true);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace1)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(0, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace2)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(1, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace3)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(2, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace4)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(3, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace5)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(4, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace6)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(5, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace7)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(6, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace8)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(7, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace9)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(8, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace10)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(9, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace11)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(10, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace12)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(11, false);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace1TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(0, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace2TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(1, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace3TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(2, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace4TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(3, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace5TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(4, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace6TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(5, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace7TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(6, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace8TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(7, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace9TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(8, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace10TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(9, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace11TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(10, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysWorkspace12TakeWin)) {
-        XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
-        switchToWorkspace(11, true);
-        return true;
-    } else if (IS_WMKEY(k, vm, gKeySysTileVertical)) {
+    case skTileVertical:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionTileVertical, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysTileHorizontal)) {
+    case skTileHorizontal:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionTileHorizontal, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysCascade)) {
+    case skCascade:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionCascade, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysArrange)) {
+    case skArrange:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionArrange, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysUndoArrange)) {
+    case skUndoArrange:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionUndoArrange, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysArrangeIcons)) {
+    case skArrangeIcons:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionArrangeIcons, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysMinimizeAll)) {
+    case skMinimizeAll:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionMinimizeAll, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysHideAll)) {
+    case skHideAll:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionHideAll, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysAddressBar)) {
+    case skAddressBar:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         if (taskBar) {
             taskBar->showAddressBar();
             return true;
         }
-    } else if (IS_WMKEY(k, vm, gKeySysShowDesktop)) {
+        break;
+    case skShowDesktop:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         wmActionListener->actionPerformed(actionShowDesktop, 0);
         return true;
-    } else if (IS_WMKEY(k, vm, gKeySysCollapseTaskBar)) {
+    case skCollapseTaskBar:
         XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
         if (taskBar)
             taskBar->handleCollapseButton();
         return true;
 
-    } else if (IS_WMKEY(k, vm, gKeyTaskBarSwitchPrev)) {
+    case skTaskBarSwitchPrev:
         if (taskBar)
             taskBar->switchToPrev();
         return true;
-    } else if (IS_WMKEY(k, vm, gKeyTaskBarSwitchNext)) {
+    case skTaskBarSwitchNext:
         if (taskBar)
             taskBar->switchToNext();
         return true;
-    } else if (IS_WMKEY(k, vm, gKeyTaskBarMovePrev)) {
+    case skTaskBarMovePrev:
         if (taskBar)
             taskBar->movePrev();
         return true;
-    } else if (IS_WMKEY(k, vm, gKeyTaskBarMoveNext)) {
+    case skTaskBarMoveNext:
         if (taskBar)
             taskBar->moveNext();
         return true;
     }
+
+    const WinKeyAction winAction = winKeyAction(k, vm);
+    if (winAction != wkNone) {
+        if (frame && !frame->frameOption(YFrameWindow::foFullKeys) &&
+            frame->handleWinKey(winAction))
+        {
+            XAllowEvents(xapp->display(), AsyncKeyboard, key.time);
+        } else {
+            XAllowEvents(xapp->display(), ReplayKeyboard, key.time);
+        }
+        return true;
+    }
     return false;
 }
 
@@ -594,12 +661,9 @@ void YWindowManager::handleButton(const XButtonEvent &button) {
             KeySym k = button.button - Button1 + XK_Pointer_Button1;
             unsigned int m = KEY_MODMASK(button.state);
             unsigned int vm = VMod(m);
-            KProgramIterType p = keyProgs.iterator();
-            while (++p) {
-                if (p->isKey(k, vm)) {
-                    p->open(m);
-                    break;
-                }
+            int action = fSysKeys.find(k, vm) - skCount;
+            if (inrange(action, 0, keyProgs.getCount() - 1)) {
+                keyProgs[action]->open(m);
             }
         }
     }
@@ -785,6 +849,7 @@ void YWindowManager::handleClientMessage(const XClientMessageEvent &message) {
         case ICEWM_ACTION_ABOUT:
         case ICEWM_ACTION_WINOPTIONS:
         case ICEWM_ACTION_RELOADKEYS:
+        case ICEWM_ACTION_EVENTSTATS:
             smActionListener->handleSMAction(action);
             break;
         }
@@ -896,7 +961,7 @@ void YWindowManager::setFocus(YFrameWindow *f, bool canWarp) {
         if (ff) switchFocusFrom(ff);
     }
 
-    if (f && f->visible()) {
+    if (f && f->visible() && f->visibleNow()) {
         if (c && c->visible() && !(f->isRollup() || f->isIconic()))
             w = c->handle();
         else
@@ -995,6 +1060,7 @@ void YWindowManager::setTop(long layer, YFrameWindow *top) {
         }
     fLayers[layer].prepend(top);
     fLayeredUpdated = true;
+    fStackRanked = false;
     if (true || !clientMouseActions) // some programs are buggy
         if (fLayers[layer]) {
             if (raiseOnClickClient &&
@@ -1010,6 +1076,7 @@ YFrameWindow *YWindowManager::bottom(long layer) const {
 void YWindowManager::setBottom(long layer, YFrameWindow *bottom) {
     fLayers[layer].append(bottom);
     fLayeredUpdated = true;
+    fStackRanked = false;
 }
 
 void YWindowManager::installColormap(Colormap cmap) {
@@ -1036,6 +1103,106 @@ void YWindowManager::setColormapWindow(YFrameWindow *frame) {
     }
 }
 
+// split _ICEWM_RESTART_STATE, if it was saved by this process before
+// exec, into its sections of client windows: creation order, stacking
+// from the top, focus order from old to new and task order
+static bool restartSections(const YProperty& state,
+                            const long** windows, long* counts, int sections)
+{
+    if (state.size() < 1 || state[0] != long(getpid()))
+        return false;
+
+    unsigned long pos = 1;
+    for (int i = 0; i < sections; ++i) {
+        if (pos >= state.size())
+            return false;
+        counts[i] = state[int(pos)];
+        if (counts[i] < 0 || pos + 1 + counts[i] > state.size())
+            return false;
+        windows[i] = state.data<long>() + pos + 1;
+        pos += 1 + counts[i];
+    }
+    return true;
+}
+
+void YWindowManager::saveRestartState() {
+    YArray<long> state;
+    state.append(long(getpid()));
+
+    state.append(fCreationOrder.count());
+    for (YFrameIter frame = fCreationOrder.iterator(); ++frame; )
+        state.append(frame->client()->handle());
+
+    int at = state.getCount();
+    state.append(0L);
+    for (YFrameWindow* frame = topLayer(); frame; frame = frame->nextLayer())
+        if (frame->client())
+            state.append(frame->client()->handle());
+    state[at] = state.getCount() - at - 1;
+
+    state.append(fFocusedOrder.count());
+    for (YFrameIter frame = fFocusedOrder.iterator(); ++frame; )
+        state.append(frame->client()->handle());
+
+    at = state.getCount();
+    state.append(0L);
+    if (taskBar) {
+        int count = fCreationOrder.count();
+        asmart<long> order(new long[count]);
+        for (int i = 0; i < count; ++i)
+            order[i] = None;
+        for (YFrameIter frame = fCreationOrder.iterator(); ++frame; ) {
+            int k = taskBar->tasksPosition(frame);
+            if (inrange(k, 0, count - 1))
+                order[k] = frame->client()->handle();
+        }
+        for (int i = 0; i < count; ++i)
+            if (order[i])
+                state.append(order[i]);
+    }
+    state[at] = state.getCount() - at - 1;
+
+    XChangeProperty(xapp->display(), handle(),
+                    _XA_ICEWM_RESTART_STATE, XA_CARDINAL, 32,
+                    PropModeReplace,
+                    reinterpret_cast<const unsigned char *>(&state[0]),
+                    state.getCount());
+}
+
+void YWindowManager::restoreRestartState(const long* const* windows,
+                                         const long* counts)
+{
+    for (long k = counts[1]; 0 < k--; ) {
+        YFrameWindow* frame = findFrame(windows[1][k]);
+        if (frame) {
+            frame->removeFrame();
+            frame->insertFrame(true);
+        }
+    }
+    for (long k = 0; k < counts[2]; ++k) {
+        YFrameWindow* frame = findFrame(windows[2][k]);
+        if (frame)
+            raiseFocusFrame(frame);
+    }
+    fTaskOrder.clear();
+    for (long k = 0; k < counts[3]; ++k)
+        fTaskOrder.append(windows[3][k]);
+    restoreTaskOrder();
+    restackWindows();
+}
+
+void YWindowManager::restoreTaskOrder() {
+    if (taskBar && fTaskOrder.nonempty()) {
+        int pos = 0;
+        for (int k = 0; k < fTaskOrder.getCount(); ++k) {
+            YFrameWindow* frame = findFrame(fTaskOrder[k]);
+            if (frame && taskBar->tasksPosition(frame) >= 0)
+                taskBar->moveTasksApp(frame, pos++);
+        }
+        fTaskOrder.clear();
+    }
+}
+
 void YWindowManager::manageClients() {
     unsigned int clientCount;
     Window winRoot, winParent;
@@ -1047,10 +1214,60 @@ void YWindowManager::manageClients() {
     XQueryTree(xapp->display(), handle(),
                &winRoot, &winParent, &winClients, &clientCount);
 
-    if (winClients)
+    YProperty state(this, _XA_ICEWM_RESTART_STATE, F32, 1L << 20,
+                    XA_CARDINAL, True);
+    const long* windows[RestartSections] = {};
+    long counts[RestartSections] = {};
+    bool restart = restartSections(state, windows, counts, RestartSections);
+
+    if (winClients) {
+        // after a restart adopt the windows which still exist
+        // in their previous creation order, then any others
+        YArray<Window> order;
+        asmart<bool> taken(new bool[clientCount]);
+        for (unsigned int i = 0; i < clientCount; i++)
+            taken[i] = false;
+        for (long k = 0; restart && k < counts[0]; ++k) {
+            for (unsigned int i = 0; i < clientCount; i++) {
+                if (taken[i] == false && winClients[i] == Window(windows[0][k])) {
+                    taken[i] = true;
+                    order.append(winClients[i]);
+                    break;
+                }
+            }
+        }
         for (unsigned int i = 0; i < clientCount; i++)
-            if (findClient(winClients[i]) == nullptr)
-                manageClient(winClients[i]);
+            if (taken[i] == false)
+                order.append(winClients[i]);
+
+        // keep the requests for a number of windows ahead of adoption
+        // in flight, such that their replies are there when needed
+        const int ahead = 32;
+        const int count = order.getCount();
+        timeval start(monotime());
+        int adopted = 0;
+        YPrefetch prefetch;
+
+        for (int i = 0; i < count + ahead; i++) {
+            if (i < count && findClient(order[i]) == nullptr)
+                prefetch.request(order[i]);
+            if (i >= ahead) {
+                Window window = order[i - ahead];
+                if (findClient(window) == nullptr && manageClient(window))
+                    adopted++;
+                prefetch.release(window);
+            }
+        }
+        if (restart)
+            restoreRestartState(windows, counts);
+
+        if (YTrace::traces("phase")) {
+            timeval spent(monotime() - start);
+            tlog("adopted %d of %u windows in %ld ms%s", adopted, clientCount,
+                 spent.tv_sec * 1000L + spent.tv_usec / 1000L,
+                 restart ? " after restart" : "");
+        }
+    }
 
     setWmState(wmRUNNING);
     ungrabServer();
@@ -1099,11 +1316,18 @@ void YWindowManager::unmanageClients() {
         }
     }
 
+    // don't leave the released clients in the root properties
+    if (fClientListPending) {
+        fClientListPending = false;
+        publishClientLists();
+    }
+
     XSetInputFocus(xapp->display(), PointerRoot, RevertToNone, CurrentTime);
     notifyActive(nullptr);
     ungrabServer();
     XSync(xapp->display(), True);
     unlockWorkArea();
+    XFlush(xapp->display());
 }
 
 static int addco(int *v, int &n, int c) {
@@ -1128,54 +1352,42 @@ static int addco(int *v, int &n, int c) {
     return 1;
 }
 
-int YWindowManager::calcCoverage(bool down, YFrameWindow *frame1, int x, int y, int w, int h) {
-    int cover = 0;
-    int factor = down ? 2 : 1; // try harder not to cover top windows
-    const YRect rect(x, y, w, h);
-
-    YFrameWindow *frame = nullptr;
-
-    if (down) {
-        frame = top(frame1->getActiveLayer());
-    } else {
-        frame = frame1;
-    }
-    for (YFrameWindow * f = frame; f ; f = (down ? f->next() : f->prev())) {
-        if (f == frame1 || f->isMinimized() || f->isHidden() || !f->isManaged())
-            continue;
-
-        if (!f->isAllWorkspaces() && f->getWorkspace() != frame1->getWorkspace())
-            continue;
-
-        cover += rect.overlap(f->geometry()) * factor;
+// does frame f count for the coverage of a placement of frame1
+static bool covers(YFrameWindow* frame1, YFrameWindow* f) {
+    return f != frame1 && !f->isMinimized() && !f->isHidden() &&
+           f->isManaged() && (f->isAllWorkspaces() ||
+                              f->getWorkspace() == frame1->getWorkspace());
+}
 
-        if (factor > 1)
-            factor /= 2;
+// the coverage of placements of frame1 by the other frames:
+// placing down counts frames in the layer, the top one twice,
+// to try harder not to cover top windows, otherwise frames above
+void YWindowManager::addCoverage(bool down, YFrameWindow* frame1,
+                                 YCoverage& coverage)
+{
+    int factor = down ? 2 : 1;
+    YFrameWindow* f = down ? top(frame1->getActiveLayer()) : frame1->prev();
+    for (; f; f = down ? f->next() : f->prev()) {
+        if (covers(frame1, f)) {
+            coverage.add(f->geometry(), factor);
+            factor = 1;
+        }
     }
-    //msg("coverage %d %d %d %d = %d", x, y, w, h, cover);
-    return cover;
+    coverage.build();
 }
 
-void YWindowManager::tryCover(bool down, YFrameWindow *frame, int x, int y, int w, int h,
-                              int &px, int &py, int &cover, int xiscreen)
+void YWindowManager::tryCover(const YCoverage& coverage, const YRect& area,
+                              int x, int y, int w, int h,
+                              int &px, int &py, long long &cover)
 {
-    int ncover;
-
-    int mx, my, Mx, My;
-    getWorkArea(frame, &mx, &my, &Mx, &My, xiscreen);
-
-    if (x < mx)
-        return ;
-    if (y < my)
-        return ;
-    if (x + w > Mx)
-        return ;
-    if (y + h > My)
-        return ;
+    if (x < area.x() || y < area.y() ||
+        x + w > area.x() + int(area.width()) ||
+        y + h > area.y() + int(area.height()))
+        return;
 
-    ncover = calcCoverage(down, frame, x, y, w, h);
+    long long ncover = coverage.coverage(YRect(x, y, w, h));
     if (ncover < cover) {
-        //msg("min: %d %d %d", ncover, x, y);
+        //msg("min: %lld %d %d", ncover, x, y);
         px = x;
         py = y;
         cover = ncover;
@@ -1185,10 +1397,12 @@ void YWindowManager::tryCover(bool down, YFrameWindow *frame, int x, int y, int
 bool YWindowManager::getSmartPlace(bool down, YFrameWindow *frame1, int &x, int &y, int w, int h, int xiscreen) {
     int mx, my, Mx, My;
     getWorkArea(frame1, &mx, &my, &Mx, &My, xiscreen);
+    const YRect area(mx, my, max(0, Mx - mx), max(0, My - my));
 
     x = mx;
     y = my;
-    int cover, px, py;
+    int px, py;
+    long long cover;
     int *xcoord, *ycoord;
     int xcount, ycount;
     int n = 0;
@@ -1231,17 +1445,22 @@ bool YWindowManager::getSmartPlace(bool down, YFrameWindow *frame1, int &x, int
     assert(xcount <= n);
     assert(ycount <= n);
 
+    YRect bounds(area);
+    bounds.unionRect(x, y, w, h);
+    YCoverage coverage(bounds);
+    addCoverage(down, frame1, coverage);
+
     int xn = 0, yn = 0;
     px = x; py = y;
-    cover = calcCoverage(down, frame1, x, y, w, h);
+    cover = coverage.coverage(YRect(x, y, w, h));
     while (true) {
         x = xcoord[xn];
         y = ycoord[yn];
 
-        tryCover(down, frame1, x - w, y - h, w, h, px, py, cover, xiscreen);
-        tryCover(down, frame1, x - w, y    , w, h, px, py, cover, xiscreen);
-        tryCover(down, frame1, x    , y - h, w, h, px, py, cover, xiscreen);
-        tryCover(down, frame1, x    , y    , w, h, px, py, cover, xiscreen);
+        tryCover(coverage, area, x - w, y - h, w, h, px, py, cover);
+        tryCover(coverage, area, x - w, y    , w, h, px, py, cover);
+        tryCover(coverage, area, x    , y - h, w, h, px, py, cover);
+        tryCover(coverage, area, x    , y    , w, h, px, py, cover);
 
         if (cover == 0)
             break;
@@ -1267,6 +1486,8 @@ void YWindowManager::smartPlace(YFrameWindow **w, int count) {
     if (count == 0)
         return;
 
+    // each placement sees the frames placed before it, so apply at once
+    beginGeometry();
     int n = getScreenCount();
     for (int s = 0; s < n; s++)
     {
@@ -1281,6 +1502,7 @@ void YWindowManager::smartPlace(YFrameWindow **w, int count) {
             }
         }
     }
+    commitGeometry();
 }
 
 void YWindowManager::getCascadePlace(YFrameWindow *frame, int &lastX, int &lastY, int &x, int &y, int w, int h) {
@@ -1317,14 +1539,16 @@ void YWindowManager::cascadePlace(YFrameWindow **w, int count) {
 
     int lx = mx;
     int ly = my;
+    beginGeometry();
     for (int i = count; i > 0; i--) {
         YFrameWindow *f = w[i - 1];
         int x;
         int y;
 
         getCascadePlace(f, lx, ly, x, y, f->width(), f->height());
-        f->setNormalPositionOuter(x, y);
+        stagePosition(f, x, y);
     }
+    commitGeometry();
 }
 
 void YWindowManager::setWindows(YFrameWindow **w, int count, YAction action) {
@@ -1334,6 +1558,7 @@ void YWindowManager::setWindows(YFrameWindow **w, int count, YAction action) {
         return;
 
     lockFocus();
+    beginGeometry();
     for (int i = 0; i < count; ++i) {
         YFrameWindow *f = w[i];
         if (action == actionHideAll) {
@@ -1344,6 +1569,7 @@ void YWindowManager::setWindows(YFrameWindow **w, int count, YAction action) {
                 f->setState(WinStateMinimized, WinStateMinimized);
         }
     }
+    commitGeometry();
     unlockFocus();
     focusTopWindow();
 }
@@ -1477,6 +1703,7 @@ YFrameWindow *YWindowManager::manageClient(Window win, bool mapClient) {
     bool canManualPlace = false;
     bool doActivate = (wmState() == YWindowManager::wmRUNNING);
     bool requestFocus = true;
+    YPrefetch prefetch;
 
     MSG(("managing window 0x%lX", win));
     PRECONDITION(findFrame(win) == nullptr);
@@ -1496,7 +1723,8 @@ YFrameWindow *YWindowManager::manageClient(Window win, bool mapClient) {
     if (client == nullptr) {
         XWindowAttributes attributes;
 
-        if (!XGetWindowAttributes(xapp->display(), win, &attributes))
+        prefetch.request(win);
+        if (!YPrefetch::attributes(win, &attributes))
             goto end;
 
         if (attributes.override_redirect)
@@ -1721,24 +1949,27 @@ void YWindowManager::focusTopWindow() {
         notifyActive(nullptr);
         return ;
     }
-    if (!focusTop(topLayer(WinLayerOnTop)))
-        focusTop(topLayer());
-}
 
-bool YWindowManager::focusTop(YFrameWindow *f) {
-    if (!f)
-        return false;
-
-    f = f->findWindow(YFrameWindow::fwfVisible |
-                      YFrameWindow::fwfFocusable |
-                      YFrameWindow::fwfNotHidden |
-                      YFrameWindow::fwfWorkspace |
-                      YFrameWindow::fwfSame |
-                      YFrameWindow::fwfLayers |
-                      YFrameWindow::fwfCycle);
-    //msg("found focus %lX", f);
-    setFocus(f);
-    return f;
+    // the top focusable frame, preferably not above the on-top layer
+    YArray<YFrameWindow*> frames;
+    stackedOn(activeWorkspace(), frames);
+    YFrameWindow* top = nullptr;
+    for (YFrameWindow* f : frames) {
+        if (f->visible() &&
+            f->canFocus() &&
+            f->isHidden() == false &&
+            f->client()->adopted() &&
+            f->client()->destroyed() == false)
+        {
+            if (f->getActiveLayer() <= WinLayerOnTop) {
+                top = f;
+                break;
+            }
+            if (top == nullptr)
+                top = f;
+        }
+    }
+    setFocus(top);
 }
 
 YFrameWindow *YWindowManager::getFrameUnderMouse(long workspace) {
@@ -1748,8 +1979,19 @@ YFrameWindow *YWindowManager::getFrameUnderMouse(long workspace) {
     xsmart<char> title;
     int ignore;
     unsigned ignore2;
-    if (XQueryPointer(xapp->display(), xapp->root(), &root, &xwin,
-                      &ignore, &ignore, &ignore, &ignore, &ignore2) &&
+    bool query = XQueryPointer(xapp->display(), xapp->root(), &root, &xwin,
+                               &ignore, &ignore, &ignore, &ignore, &ignore2);
+    for (int i = 0; query && xwin && i < fContainers.getCount(); ++i) {
+        if (fContainers[i]->handle() == xwin) {
+            Window parent = xwin;
+            xwin = None;
+            query = XQueryPointer(xapp->display(), parent, &root, &xwin,
+                                  &ignore, &ignore, &ignore, &ignore,
+                                  &ignore2);
+            break;
+        }
+    }
+    if (query &&
         xwin != None &&
         (ywin = windowContext.find(xwin)) != nullptr &&
         !ywin->adopted() &&
@@ -1794,12 +2036,13 @@ YFrameWindow *YWindowManager::getLastFocus(bool skipAllWorkspaces, long workspac
     }
 
     if (toFocus == nullptr) {
+        YArray<YFrameWindow*> frames;
+        focusedOn(workspace, frames);
         int pass = 0;
         if (!skipAllWorkspaces)
             pass = 1;
         for (; pass < 3; pass++) {
-            YFrameIter w = focusedReverseIterator();
-            while (++w) {
+            for (YFrameWindow* w : frames) {
 #if 1
                 if ((w->client() && !w->client()->adopted()))
                     continue;
@@ -1808,8 +2051,6 @@ YFrameWindow *YWindowManager::getLastFocus(bool skipAllWorkspaces, long workspac
                     continue;
                 if (w->isHidden())
                     continue;
-                if (!w->visibleOn(workspace))
-                    continue;
                 if (w->avoidFocus() || pass == 2)
                     continue;
                 if ((w->isAllWorkspaces() && w != fFocusWin) || pass == 1) {
@@ -1886,6 +2127,37 @@ YFrameWindow *YWindowManager::bottomLayer(long layer) {
     return nullptr;
 }
 
+YGrid<YFrameWindow>& YWindowManager::frameIndex(int workspace) {
+    while (fFrameIndex.getCount() <= workspace + 1) {
+        YGrid<YFrameWindow>* grid = new YGrid<YFrameWindow>;
+        grid->resize(width(), height());
+        fFrameIndex.append(grid);
+    }
+    return *fFrameIndex[workspace + 1];
+}
+
+void YWindowManager::indexFrame(YFrameWindow* frame) {
+    frameIndex(frame->getWorkspace()).insert(frame, frame->geometry());
+}
+
+void YWindowManager::reindexFrame(YFrameWindow* frame, const YRect& old) {
+    frameIndex(frame->getWorkspace()).update(frame, old, frame->geometry());
+}
+
+void YWindowManager::unindexFrame(YFrameWindow* frame) {
+    frameIndex(frame->getWorkspace()).remove(frame, frame->geometry());
+}
+
+int YWindowManager::stackRank(YFrameWindow* frame) {
+    if (fStackRanked == false) {
+        int rank = 0;
+        for (YFrameWindow* f = topLayer(); f; f = f->nextLayer())
+            f->setStackRank(rank++);
+        fStackRanked = true;
+    }
+    return frame->stackRank();
+}
+
 bool YWindowManager::setAbove(YFrameWindow* frame, YFrameWindow* above) {
     const long layer = frame->getActiveLayer();
     if (above != nullptr && layer != above->getActiveLayer()) {
@@ -1901,6 +2173,7 @@ bool YWindowManager::setAbove(YFrameWindow* frame, YFrameWindow* above) {
     if (above != frame->next() && above != frame) {
         fLayers[layer].remove(frame);
         fLayeredUpdated = true;
+        fStackRanked = false;
         if (above) {
             fLayers[layer].insertBefore(frame, above);
         } else {
@@ -1933,6 +2206,7 @@ void YWindowManager::removeLayeredFrame(YFrameWindow *frame) {
     PRECONDITION(inrange(layer, 0L, WinLayerCount - 1L));
     fLayers[layer].remove(frame);
     fLayeredUpdated = true;
+    fStackRanked = false;
 }
 
 void YWindowManager::updateFullscreenLayerEnable(bool enable) {
@@ -1954,8 +2228,78 @@ void YWindowManager::updateFullscreenLayer() { /// HACK !!!
     }
 }
 
-void YWindowManager::restackWindows() {
-    YArray<Window> w(10 + focusedCount());
+struct StackPos {
+    Window window;
+    int index;
+};
+
+static int compareStackPos(const void* p1, const void* p2) {
+    Window w1 = static_cast<const StackPos*>(p1)->window;
+    Window w2 = static_cast<const StackPos*>(p2)->window;
+    return w1 < w2 ? -1 : w1 > w2;
+}
+
+// Mark which windows keep their place when restacking from the order
+// old to the order now: those on a longest increasing subsequence of
+// their old positions. The first window keeps its place by definition.
+static void keepInPlace(const YArray<Window>& old, const YArray<Window>& now,
+                        bool* keep)
+{
+    const int count = now.getCount(), oldCount = old.getCount();
+    StackPos* sorted = new StackPos[oldCount + 1];
+    for (int i = 0; i < oldCount; ++i) {
+        sorted[i].window = old[i];
+        sorted[i].index = i;
+    }
+    qsort(sorted, oldCount, sizeof(StackPos), compareStackPos);
+
+    // tails[k] is the index in now of the last window of the best
+    // increasing subsequence of length k + 1, pred links back
+    int* pos = new int[count];
+    int* tails = new int[count + 1];
+    int* pred = new int[count];
+    int length = 0;
+    for (int i = 1; i < count; ++i) {
+        StackPos key = { now[i], 0 };
+        const StackPos* found = static_cast<const StackPos*>(
+            bsearch(&key, sorted, oldCount, sizeof(StackPos),
+                    compareStackPos));
+        pos[i] = found ? found->index : -1;
+        pred[i] = -1;
+        if (pos[i] < 0)
+            continue;
+        int lo = 0, hi = length;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (pos[tails[mid]] < pos[i])
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        pred[i] = lo ? tails[lo - 1] : -1;
+        tails[lo] = i;
+        if (lo == length)
+            length++;
+    }
+
+    for (int i = 0; i < count; ++i)
+        keep[i] = (i == 0);
+    for (int i = length ? tails[length - 1] : -1; 0 < i; i = pred[i])
+        keep[i] = true;
+
+    delete[] sorted;
+    delete[] pos;
+    delete[] tails;
+    delete[] pred;
+}
+
+void YWindowManager::flushRestack() {
+    if (fRestackPending == false)
+        return;
+    fRestackPending = false;
+
+    YArray<Window> w(10);
+    YArray<Window> frames(focusedCount() + 1);
 
     w.append(fTopWin->handle());
 
@@ -1977,12 +2321,131 @@ void YWindowManager::restackWindows() {
     if (statusMoveSize && statusMoveSize->visible())
         w.append(statusMoveSize->handle());
 
+    if (fContaining) {
+        // containers per layer, those for all workspaces on top,
+        // then frames which are not yet in a container
+        for (long layer = WinLayerCount - 1; 0 <= layer; --layer) {
+            for (int k = 0; k < 2; ++k) {
+                for (int i = 0; i < fContainers.getCount(); ++i) {
+                    WorkspaceContainer* c = fContainers[i];
+                    if (c->layer() == layer &&
+                        (c->workspace() == AllWorkspaces) == (k == 0))
+                        w.append(c->handle());
+                }
+            }
+            for (YFrameWindow* f = top(layer); f; f = f->next()) {
+                if (f->parent() == this)
+                    w.append(f->handle());
+            }
+        }
+        for (int i = 0; i < fContainers.getCount(); ++i) {
+            WorkspaceContainer* c = fContainers[i];
+            YArray<Window> inner;
+            for (YFrameWindow* f = top(c->layer()); f; f = f->next()) {
+                if (f->parent() == c)
+                    inner.append(f->handle());
+            }
+            if (inner.getCount() > 1) {
+                XRestackWindows(xapp->display(), &*inner, inner.getCount());
+            }
+        }
+        if (w.getCount() > 1) {
+            XRestackWindows(xapp->display(), &*w, w.getCount());
+        }
+        return;
+    }
+
     for (YFrameWindow* f = topLayer(); f; f = f->nextLayer()) {
-        w.append(f->handle());
+        frames.append(f->handle());
+    }
+    if (frames.isEmpty()) {
+        if (w.getCount() > 1) {
+            XRestackWindows(xapp->display(), &*w, w.getCount());
+        }
+        fStacking.clear();
+        return;
+    }
+
+    // restack the other windows with the top frame in one request,
+    // then move only the frames which are out of their old order
+    // to below their predecessor, from the top down
+    w.append(frames[0]);
+    XRestackWindows(xapp->display(), &*w, w.getCount());
+
+    const int count = frames.getCount();
+    bool* keep = new bool[count];
+    keepInPlace(fStacking, frames, keep);
+    for (int i = 1; i < count; ++i) {
+        if (keep[i] == false) {
+            XWindowChanges xwc;
+            xwc.sibling = frames[i - 1];
+            xwc.stack_mode = Below;
+            XConfigureWindow(xapp->display(), frames[i],
+                             CWSibling | CWStackMode, &xwc);
+        }
+    }
+    delete[] keep;
+    fStacking.swap(frames);
+}
+
+WorkspaceContainer* YWindowManager::container(long workspace, long layer) {
+    for (int i = 0; i < fContainers.getCount(); ++i) {
+        WorkspaceContainer* c = fContainers[i];
+        if (c->workspace() == workspace && c->layer() == layer)
+            return c;
+    }
+    WorkspaceContainer* c = new WorkspaceContainer(workspace, layer);
+    fContainers.append(c);
+    if (workspace == AllWorkspaces || workspace == fActiveWorkspace)
+        c->show();
+    restackWindows();
+    return c;
+}
+
+void YWindowManager::contain(YFrameWindow* frame) {
+    WorkspaceContainer* c = container(frame->getWorkspace(),
+                                      frame->getActiveLayer());
+    if (frame->parent() != c) {
+        frame->reparent(c, frame->x(), frame->y());
+        restackContained(frame);
+    }
+}
+
+void YWindowManager::restackContained(YFrameWindow* frame) {
+    for (YFrameWindow* f = frame->prev(); f; f = f->prev()) {
+        if (f->parent() == frame->parent()) {
+            frame->YWindow::beneath(f);
+            return;
+        }
     }
+    for (YFrameWindow* f = frame->next(); f; f = f->next()) {
+        if (f->parent() == frame->parent()) {
+            frame->YWindow::raiseTo(f);
+            return;
+        }
+    }
+}
+
+void YWindowManager::updateContainers() {
+    for (int i = 0; i < fContainers.getCount(); ++i) {
+        WorkspaceContainer* c = fContainers[i];
+        if (c->changed())
+            c->updateShape(top(c->layer()));
+    }
+}
 
-    if (w.getCount() > 1) {
-        XRestackWindows(xapp->display(), &*w, w.getCount());
+void YWindowManager::switchContainers() {
+    // map the new before unmapping the old to avoid flicker
+    for (int i = 0; i < fContainers.getCount(); ++i) {
+        WorkspaceContainer* c = fContainers[i];
+        if (c->workspace() == fActiveWorkspace)
+            c->show();
+    }
+    for (int i = 0; i < fContainers.getCount(); ++i) {
+        WorkspaceContainer* c = fContainers[i];
+        if (c->workspace() != fActiveWorkspace &&
+            c->workspace() != AllWorkspaces)
+            c->hide();
     }
 }
 
@@ -2091,29 +2554,47 @@ void YWindowManager::updateWorkArea() {
     }
 }
 
+YWindowManager::WorkAreaRect** YWindowManager::newWorkArea(long spaces,
+                                                           int screens) {
+    WorkAreaRect** area = new WorkAreaRect*[max(1L, spaces)];
+    area[0] = new WorkAreaRect[max(1L, spaces * screens)];
+    for (long i = 1; i < spaces; i++)
+        area[i] = area[i - 1] + screens;
+    return area;
+}
+
+void YWindowManager::deleteWorkArea(WorkAreaRect** area) {
+    if (area) {
+        delete [] area[0];
+        delete [] area;
+    }
+}
+
 bool YWindowManager::updateWorkAreaInner() {
     long oldWorkAreaWorkspaceCount = fWorkAreaWorkspaceCount;
     int oldWorkAreaScreenCount = fWorkAreaScreenCount;
-    WorkAreaRect **oldWorkArea = new WorkAreaRect *[::workspaceCount];
-    if (oldWorkArea == nullptr)
-        return false;
+    WorkAreaRect **oldWorkArea = fWorkArea;
+    // reuse the previous area as long as its dimensions are unchanged
+    bool reshaped = (fWorkArea == nullptr ||
+                     oldWorkAreaWorkspaceCount != ::workspaceCount ||
+                     oldWorkAreaScreenCount != getScreenCount());
+    if (reshaped) {
+        deleteWorkArea(fSpareWorkArea);
+        fSpareWorkArea = nullptr;
+        fWorkAreaWorkspaceCount = ::workspaceCount;
+        fWorkAreaScreenCount = getScreenCount();
+        fWorkArea = newWorkArea(fWorkAreaWorkspaceCount,
+                                fWorkAreaScreenCount);
+    }
     else {
-        long areaCount = ::workspaceCount * getScreenCount();
-        oldWorkArea[0] = new WorkAreaRect[areaCount];
-        if (oldWorkArea[0] == nullptr) {
-            delete[] oldWorkArea;
-            return false;
-        }
-        else {
-            fWorkAreaWorkspaceCount = ::workspaceCount;
-            fWorkAreaScreenCount = getScreenCount();
-            swap(fWorkArea, oldWorkArea);
-        }
+        if (fSpareWorkArea == nullptr)
+            fSpareWorkArea = newWorkArea(fWorkAreaWorkspaceCount,
+                                         fWorkAreaScreenCount);
+        fWorkArea = fSpareWorkArea;
+        fSpareWorkArea = oldWorkArea;
     }
 
     for (long i = 0; i < fWorkAreaWorkspaceCount; i++) {
-        if (i)
-            fWorkArea[i] = fWorkArea[i - 1] + fWorkAreaScreenCount;
         for (int j = 0; j < fWorkAreaScreenCount; j++)
             fWorkArea[i][j] = xiInfo[j];
     }
@@ -2121,7 +2602,7 @@ bool YWindowManager::updateWorkAreaInner() {
     debugWorkArea("before");
 
     for (YFrameWindow *w = topLayer(); w; w = w->nextLayer()) {
-        if (w->client() == nullptr) {
+        if (w->client() == nullptr || w->affectsWorkArea() == false) {
             continue;
         }
         if (w->hasState(WinStateHidden | WinStateMinimized | WinStateRollup)) {
@@ -2193,9 +2674,7 @@ bool YWindowManager::updateWorkAreaInner() {
     debugWorkArea("after");
 
     bool changed = false;
-    if (oldWorkArea == nullptr ||
-        oldWorkAreaWorkspaceCount != fWorkAreaWorkspaceCount ||
-        oldWorkAreaScreenCount != fWorkAreaScreenCount) {
+    if (oldWorkArea == nullptr || reshaped) {
         changed = true;
     } else {
         for (long ws = 0; ws < fWorkAreaWorkspaceCount; ws++) {
@@ -2260,14 +2739,15 @@ bool YWindowManager::updateWorkAreaInner() {
         }
     }
 
-    if (oldWorkArea) {
-        delete [] oldWorkArea[0];
-        delete [] oldWorkArea;
-    }
     if (resize) {
         MSG(("resizeWindows"));
-        resizeWindows();
+        if (reshaped)
+            resizeWindows();
+        else
+            resizeWindows(oldWorkArea);
     }
+    if (reshaped)
+        deleteWorkArea(oldWorkArea);
     return resize | changed;
 }
 
@@ -2357,6 +2837,27 @@ void YWindowManager::resizeWindows() {
     }
 }
 
+// resize only the windows whose work area differs from the old one
+void YWindowManager::resizeWindows(WorkAreaRect** oldWorkArea) {
+    const long ws = activeWorkspace();
+    if (!inrange(ws, 0L, fWorkAreaWorkspaceCount - 1L))
+        return resizeWindows();
+
+    YArray<YFrameWindow*> frames;
+    focusedOn(ws, frames);
+    for (YFrameWindow* f : frames) {
+        int s = f->getScreen();
+        if (inrange(s, 0, fWorkAreaScreenCount - 1) &&
+            fWorkArea[ws][s] != oldWorkArea[ws][s] &&
+            f->inWorkArea() && !f->client()->destroyed())
+        {
+            if (f->isMaximized())
+                f->updateDerivedSize(WinStateMaximizedBoth);
+            f->updateLayout();
+        }
+    }
+}
+
 void YWindowManager::workAreaUpdated() {
     if (wmState() == wmRUNNING && (taskBar || !showTaskBar)) {
         for (YFrameIter frame = fCreationOrder.iterator(); ++frame; ) {
@@ -2411,17 +2912,24 @@ void YWindowManager::activateWorkspace(long workspace) {
 #endif
         resizeWindows();
 
-        for (YFrameWindow* w = topLayer(); w; w = w->nextLayer())
-            if (w->visibleNow()) {
-                w->updateState();
+        if (fContaining) {
+            switchContainers();
+            for (YFrameWindow* w = topLayer(); w; w = w->nextLayer())
                 w->updateTaskBar();
-            }
+        }
+        else {
+            for (YFrameWindow* w = topLayer(); w; w = w->nextLayer())
+                if (w->visibleNow()) {
+                    w->updateState();
+                    w->updateTaskBar();
+                }
 
-        for (YFrameWindow* w = bottomLayer(); w; w = w->prevLayer())
-            if (!w->visibleNow()) {
-                w->updateState();
-                w->updateTaskBar();
-            }
+            for (YFrameWindow* w = bottomLayer(); w; w = w->prevLayer())
+                if (!w->visibleNow()) {
+                    w->updateState();
+                    w->updateTaskBar();
+                }
+        }
         unlockFocus();
 
         YFrameWindow *toFocus = getLastFocus(true, workspace);
@@ -2487,6 +2995,18 @@ void YWindowManager::removeLastWorkspaces(long minus) {
     for (int i = 1; i <= minus && last + 1 < workspaces.count(); ++i)
         workspaces.drop();
 
+    // the containers of the removed workspaces should be empty now
+    for (int i = fContainers.getCount(); --i >= 0; ) {
+        WorkspaceContainer* c = fContainers[i];
+        if (c->workspace() > last) {
+            for (YFrameIter frame(focusedIterator()); ++frame; ) {
+                if (frame->parent() == c)
+                    contain(frame);
+            }
+            fContainers.remove(i);
+        }
+    }
+
     updateWorkspaces(false);
 
     if (refocus)
@@ -2845,16 +3365,15 @@ void YWindowManager::getIconPosition(YFrameWindow *frame, int *iconX, int *iconY
 int YWindowManager::windowCount(long workspace) {
     int count = 0;
 
-    for (int layer = 0 ; layer < WinLayerCount; layer++) {
-        for (YFrameWindow *frame = top(layer); frame; frame = frame->next()) {
-            if (!frame->visibleOn(workspace))
-                continue;
-            if (frame->frameOption(YFrameWindow::foIgnoreWinList))
-                continue;
-            if (workspace != activeWorkspace() &&
-                frame->visibleNow())
-                continue;
+    for (YFrameIter frame = focusedList(workspace).iterator(); ++frame; ) {
+        if (!frame->frameOption(YFrameWindow::foIgnoreWinList))
             count++;
+    }
+    if (workspace == activeWorkspace() && workspace != AllWorkspaces) {
+        for (YFrameIter frame = focusedList(AllWorkspaces).iterator();
+             ++frame; ) {
+            if (!frame->frameOption(YFrameWindow::foIgnoreWinList))
+                count++;
         }
     }
     return count;
@@ -2900,15 +3419,44 @@ void YWindowManager::handleProperty(const XPropertyEvent &property) {
     }
 }
 
-void YWindowManager::updateClientList() {
-    YArray<XID> ids;
-    if (fLayeredUpdated || fCreatedUpdated) {
-        ids.setCapacity(fCreationOrder.count());
+// Change the published list of windows into ids: append when windows
+// were only added at the end, rewrite when the order changed.
+void YWindowManager::publishClientList(const Atom* props, const Atom* types,
+                                       int count, YArray<XID>& ids,
+                                       YArray<XID>& published)
+{
+    const int num = ids.getCount(), old = published.getCount();
+    if (fClientListPublished && old <= num &&
+        (old == 0 || 0 == memcmp(&*ids, &*published, old * sizeof(XID))))
+    {
+        if (old < num) {
+            for (int k = 0; k < count; ++k)
+                appendProperty(props[k], types[k], &ids[old], num - old);
+        }
     }
+    else {
+        Atom* data = num ? &*ids : nullptr;
+        for (int k = 0; k < count; ++k)
+            setProperty(props[k], types[k], data, num);
+    }
+    published.swap(ids);
+}
+
+void YWindowManager::flushClientList() {
+    if (fClientListPending == false)
+        return;
+    fClientListPending = false;
+
+    publishClientLists();
+    checkLogout();
+}
 
+void YWindowManager::publishClientLists() {
     if (fLayeredUpdated) {
         fLayeredUpdated = false;
 
+        YArray<XID> ids;
+        ids.setCapacity(fCreationOrder.count());
         for (int i = 0; i < WinLayerCount; ++i) {
             if (fLayers[i]) {
                 YFrameIter frame = fLayers[i].reverseIterator();
@@ -2920,26 +3468,27 @@ void YWindowManager::updateClientList() {
             }
         }
 
-        const int num = ids.getCount();
-        Atom* data = num ? &*ids : nullptr;
-        setProperty(_XA_WIN_CLIENT_LIST, XA_CARDINAL, data, num);
-        setProperty(_XA_NET_CLIENT_LIST_STACKING, XA_WINDOW, data, num);
+        const Atom props[] = { _XA_WIN_CLIENT_LIST,
+                               _XA_NET_CLIENT_LIST_STACKING };
+        const Atom types[] = { XA_CARDINAL, XA_WINDOW };
+        publishClientList(props, types, 2, ids, fPublishedStacking);
     }
 
     if (fCreatedUpdated) {
         fCreatedUpdated = false;
 
-        ids.shrink(0);
+        YArray<XID> ids;
+        ids.setCapacity(fCreationOrder.count());
         for (YFrameIter frame = fCreationOrder.iterator(); ++frame; ) {
             if (frame->client() && frame->client()->adopted())
                 ids.append(frame->client()->handle());
         }
 
-        const int num = ids.getCount();
-        Atom* data = num ? &*ids : nullptr;
-        setProperty(_XA_NET_CLIENT_LIST, XA_WINDOW, data, num);
+        const Atom props[] = { _XA_NET_CLIENT_LIST };
+        const Atom types[] = { XA_WINDOW };
+        publishClientList(props, types, 1, ids, fPublishedCreated);
     }
-    checkLogout();
+    fClientListPublished = true;
 }
 
 void YWindowManager::updateUserTime(const UserTime& userTime) {
@@ -3100,7 +3649,7 @@ void YWindowManager::tilePlace(YFrameWindow *w, int tx, int ty, int tw, int th)
                                0);
     tw += 2 * w->borderXN();
     th += 2 * w->borderYN() + w->titleYN();
-    w->setNormalGeometryOuter(tx, ty, tw, th);
+    stageGeometry(w, tx, ty, tw, th);
 }
 
 void YWindowManager::tileWindows(YFrameWindow **w, int count, bool vertical) {
@@ -3109,6 +3658,7 @@ void YWindowManager::tileWindows(YFrameWindow **w, int count, bool vertical) {
     if (count <= 0)
         return ;
 
+    beginGeometry();
     int curWin = 0;
     int cols = 1;
 
@@ -3166,6 +3716,7 @@ void YWindowManager::tileWindows(YFrameWindow **w, int count, bool vertical) {
         }
         windowX += windowWidth;
     }
+    commitGeometry();
 }
 
 bool YWindowManager::getWindowsToArrange(YFrameWindow ***win, int *count,
@@ -3214,19 +3765,52 @@ void YWindowManager::saveArrange(YFrameWindow **w, int count) {
     }
     setShowingDesktop(false);
 }
+
+void YWindowManager::beginGeometry() {
+    grabServer();
+    lockWorkArea();
+}
+
+void YWindowManager::stageGeometry(YFrameWindow* frame,
+                                   int x, int y, int w, int h) {
+    StagedGeometry staged = { frame, x, y, w, h, true };
+    fStagedGeometry.append(staged);
+}
+
+void YWindowManager::stagePosition(YFrameWindow* frame, int x, int y) {
+    StagedGeometry staged = { frame, x, y, 0, 0, false };
+    fStagedGeometry.append(staged);
+}
+
+void YWindowManager::commitGeometry() {
+    for (const StagedGeometry& staged : fStagedGeometry) {
+        if (staged.sized)
+            staged.frame->setNormalGeometryOuter(staged.x, staged.y,
+                                                 staged.w, staged.h);
+        else
+            staged.frame->setNormalPositionOuter(staged.x, staged.y);
+    }
+    fStagedGeometry.clear();
+    unlockWorkArea();
+    ungrabServer();
+    XFlush(xapp->display());
+}
+
 void YWindowManager::undoArrange() {
     if (fArrangeInfo) {
         lockFocus();
+        beginGeometry();
         for (int i = 0; i < fArrangeCount; i++) {
             YFrameWindow *f = fArrangeInfo[i].frame;
             if (f) {
                 f->setState(WIN_STATE_ALL, fArrangeInfo[i].state);
-                f->setNormalGeometryOuter(fArrangeInfo[i].x,
-                                          fArrangeInfo[i].y,
-                                          fArrangeInfo[i].w,
-                                          fArrangeInfo[i].h);
+                stageGeometry(f, fArrangeInfo[i].x,
+                                 fArrangeInfo[i].y,
+                                 fArrangeInfo[i].w,
+                                 fArrangeInfo[i].h);
             }
         }
+        commitGeometry();
         delete [] fArrangeInfo; fArrangeInfo = nullptr;
         fArrangeCount = 0;
         unlockFocus();
@@ -3404,6 +3988,70 @@ end:
     return false;
 }
 
+WorkspaceContainer::WorkspaceContainer(long workspace, long layer):
+    YWindow(desktop),
+    fWorkspace(workspace),
+    fLayer(layer),
+    fChanged(false)
+{
+    setStyle(wsOverrideRedirect | wsNoExpose);
+    addEventMask(SubstructureNotifyMask);
+    setGeometry();
+    setParentRelative();
+    setTitle("IceContainer");
+#ifdef CONFIG_SHAPE
+    XShapeCombineRectangles(xapp->display(), handle(), ShapeBounding,
+                            0, 0, nullptr, 0, ShapeSet, Unsorted);
+#endif
+}
+
+void WorkspaceContainer::setGeometry() {
+    YWindow::setGeometry(YRect(0, 0, desktop->width(), desktop->height()));
+}
+
+void WorkspaceContainer::updateShape(YFrameWindow* top) {
+#ifdef CONFIG_SHAPE
+    YArray<XRectangle> rects;
+    for (YFrameWindow* f = top; f; f = f->next()) {
+        if (f->parent() == this && f->visible()) {
+            XRectangle r = {
+                short(f->x()), short(f->y()),
+                (unsigned short) f->width(), (unsigned short) f->height()
+            };
+            rects.append(r);
+        }
+    }
+    XShapeCombineRectangles(xapp->display(), handle(), ShapeBounding,
+                            0, 0, rects.isEmpty() ? nullptr : &*rects,
+                            rects.getCount(), ShapeSet, Unsorted);
+#endif
+    fChanged = false;
+}
+
+void WorkspaceContainer::handleEvent(const XEvent& event) {
+    // the geometry and mapping of frames determine the shape
+    switch (event.type) {
+    case ConfigureNotify:
+        fChanged |= (event.xconfigure.window != handle());
+        break;
+    case MapNotify:
+        fChanged |= (event.xmap.window != handle());
+        break;
+    case UnmapNotify:
+        fChanged |= (event.xunmap.window != handle());
+        break;
+    case ReparentNotify:
+        fChanged |= (event.xreparent.window != handle());
+        break;
+    case DestroyNotify:
+        fChanged |= (event.xdestroywindow.window != handle());
+        break;
+    default:
+        YWindow::handleEvent(event);
+        break;
+    }
+}
+
 int YWindowManager::getSwitchScreen() {
     int s = fFocusWin ? fFocusWin->getScreen() : xineramaPrimaryScreen;
     return inrange(s, 0, getScreenCount() - 1) ? s : 0;
@@ -3446,6 +4094,8 @@ void YWindowManager::updateScreenSize(XEvent *event) {
         Atom data[2] = { nw, nh };
         setProperty(_XA_NET_DESKTOP_GEOMETRY, XA_CARDINAL, data, 2);
         setSize(nw, nh);
+        for (int i = 0; i < fFrameIndex.getCount(); ++i)
+            fFrameIndex[i]->resize(nw, nh);
         updateWorkArea();
         if (taskBar && pagerShowPreview) {
             taskBar->workspacesUpdateButtons();
@@ -3456,6 +4106,8 @@ void YWindowManager::updateScreenSize(XEvent *event) {
         }
         for (int i = 0; i < edges.getCount(); ++i)
             edges[i]->setGeometry();
+        for (int i = 0; i < fContainers.getCount(); ++i)
+            fContainers[i]->setGeometry();
 
         /// TODO #warning "make something better"
         if (arrangeWindowsOnScreenSizeChange) {
@@ -3488,23 +4140,44 @@ void YWindowManager::removeCreatedFrame(YFrameWindow *f) {
     fCreatedUpdated = true;
 }
 
+YWorkspaceList& YWindowManager::focusedList(long workspace) {
+    while (fWorkspaceFocus.getCount() <= workspace + 1)
+        fWorkspaceFocus.append(new YWorkspaceList);
+    return *fWorkspaceFocus[workspace + 1];
+}
+
 void YWindowManager::insertFocusFrame(YFrameWindow* frame, bool focused) {
+    YWorkspaceList& list(focusedList(frame->getWorkspace()));
     if (focused || fFocusedOrder.count() < 1) {
         fFocusedOrder.append(frame);
+        list.append(frame);
+        frame->setFocusStamp(++fFocusStampHigh);
     }
     else {
-        fFocusedOrder.insertBefore(frame, fFocusedOrder.back());
+        YFrameWindow* last = fFocusedOrder.back();
+        fFocusedOrder.insertBefore(frame, last);
+        if (last->getWorkspace() == frame->getWorkspace())
+            list.insertBefore(frame, last);
+        else
+            list.append(frame);
+        frame->setFocusStamp(last->focusStamp());
+        last->setFocusStamp(++fFocusStampHigh);
     }
 }
 
 void YWindowManager::removeFocusFrame(YFrameWindow* frame) {
     fFocusedOrder.remove(frame);
+    focusedList(frame->getWorkspace()).remove(frame);
 }
 
 void YWindowManager::lowerFocusFrame(YFrameWindow* frame) {
     if (frame->YFocusedNode::nodePrev()) {
         fFocusedOrder.remove(frame);
         fFocusedOrder.prepend(frame);
+        YWorkspaceList& list(focusedList(frame->getWorkspace()));
+        list.remove(frame);
+        list.prepend(frame);
+        frame->setFocusStamp(--fFocusStampLow);
     }
 }
 
@@ -3512,6 +4185,62 @@ void YWindowManager::raiseFocusFrame(YFrameWindow* frame) {
     if (frame->YFocusedNode::nodeNext()) {
         fFocusedOrder.remove(frame);
         fFocusedOrder.append(frame);
+        YWorkspaceList& list(focusedList(frame->getWorkspace()));
+        list.remove(frame);
+        list.append(frame);
+        frame->setFocusStamp(++fFocusStampHigh);
+    }
+}
+
+// move a frame to the focus list of its new workspace
+void YWindowManager::refileFocusFrame(YFrameWindow* frame, int previous) {
+    if (frame->YFocusedNode::zero() && fFocusedOrder.front() != frame)
+        return;
+
+    focusedList(previous).remove(frame);
+    YFrameWindow* next = frame->YFocusedNode::nextFrame();
+    while (next && next->getWorkspace() != frame->getWorkspace())
+        next = next->YFocusedNode::nextFrame();
+    YWorkspaceList& list(focusedList(frame->getWorkspace()));
+    if (next)
+        list.insertBefore(frame, next);
+    else
+        list.append(frame);
+}
+
+void YWindowManager::focusedOn(long workspace,
+                               YArray<YFrameWindow*>& frames) {
+    YFrameWindow* w = focusedList(workspace).back();
+    YFrameWindow* a = (workspace == AllWorkspaces) ? nullptr
+                    : focusedList(AllWorkspaces).back();
+    while (w || a) {
+        if (a == nullptr || (w && a->focusStamp() < w->focusStamp())) {
+            frames.append(w);
+            w = w->YWorkspaceNode::prevFrame();
+        } else {
+            frames.append(a);
+            a = a->YWorkspaceNode::prevFrame();
+        }
+    }
+}
+
+static int compareStackRank(const void* p1, const void* p2) {
+    const YFrameWindow* f1 = *static_cast<YFrameWindow* const*>(p1);
+    const YFrameWindow* f2 = *static_cast<YFrameWindow* const*>(p2);
+    return f1->stackRank() - f2->stackRank();
+}
+
+void YWindowManager::stackedOn(long workspace,
+                               YArray<YFrameWindow*>& frames) {
+    for (YFrameIter w = focusedList(workspace).iterator(); ++w; )
+        frames.append(w);
+    if (workspace != AllWorkspaces)
+        for (YFrameIter a = focusedList(AllWorkspaces).iterator(); ++a; )
+            frames.append(a);
+    if (frames.nonempty()) {
+        stackRank(frames[0]);
+        qsort(&*frames, frames.getCount(), sizeof(YFrameWindow*),
+              compareStackRank);
     }
 }
 
@@ -6,9 +6,41 @@
 #include "yaction.h"
 #include "ymsgbox.h"
 #include "workspaces.h"
+#include "ygrid.h"
+#include "ycover.h"
+#include "ykeytable.h"
 
 extern YAction layerActionSet[WinLayerCount];
 
+// actions of the global key bindings, then those of keyProgs
+enum SysKeyAction {
+    skSwitchNext, skSwitchLast, skSwitchClass, skWinNext, skWinPrev,
+    skWinMenu, skDialog, skWinListMenu, skMenu, skWindowList,
+    skWorkspacePrev, skWorkspaceNext, skWorkspaceLast,
+    skWorkspacePrevTakeWin, skWorkspaceNextTakeWin, skWorkspaceLastTakeWin,
+    skWorkspace1,
+    skWorkspace1TakeWin = skWorkspace1 + 12,
+    skTileVertical = skWorkspace1TakeWin + 12,
+    skTileHorizontal, skCascade, skArrange, skUndoArrange, skArrangeIcons,
+    skMinimizeAll, skHideAll, skAddressBar, skShowDesktop,
+    skCollapseTaskBar, skTaskBarSwitchPrev, skTaskBarSwitchNext,
+    skTaskBarMovePrev, skTaskBarMoveNext,
+    skCount
+};
+
+// actions of the key bindings of frames
+enum WinKeyAction {
+    wkNone = -1,
+    wkClose, wkPrev, wkMaximizeVert, wkMaximizeHoriz, wkRaise, wkOccupyAll,
+    wkLower, wkRestore, wkNext, wkMove, wkSize, wkMinimize, wkMaximize,
+    wkHide, wkRollup, wkFullscreen, wkMenu, wkArrangeN, wkArrangeNE,
+    wkArrangeE, wkArrangeSE, wkArrangeS, wkArrangeSW, wkArrangeW,
+    wkArrangeNW, wkArrangeC, wkSnapMoveN, wkSnapMoveNE, wkSnapMoveE,
+    wkSnapMoveSE, wkSnapMoveS, wkSnapMoveSW, wkSnapMoveW, wkSnapMoveNW,
+    wkSmartPlace,
+    wkCount
+};
+
 class YStringList;
 class YWindowManager;
 class YFrameClient;
@@ -73,6 +105,29 @@ private:
     lazy<YTimer> fEdgeSwitchTimer;
 };
 
+// With WorkspaceContainers the frames of one layer on one workspace,
+// or on all workspaces, are children of a container window. A switch
+// of workspace maps the containers of the new workspace and unmaps those
+// of the old, instead of every frame. The bounding shape of a container
+// is the union of its mapped frames, so it hides nothing else.
+class WorkspaceContainer: public YWindow {
+public:
+    WorkspaceContainer(long workspace, long layer);
+
+    long workspace() const { return fWorkspace; }
+    long layer() const { return fLayer; }
+    bool changed() const { return fChanged; }
+    void updateShape(YFrameWindow* top);
+    void setGeometry();
+
+    virtual void handleEvent(const XEvent& event);
+
+private:
+    long fWorkspace;
+    long fLayer;
+    bool fChanged;
+};
+
 class YProxyWindow: public YWindow {
 public:
     YProxyWindow(YWindow *parent);
@@ -93,6 +148,13 @@ public:
     virtual ~YWindowManager();
 
     virtual void grabKeys();
+    // compile the key bindings into tables
+    void updateKeys();
+    WinKeyAction winKeyAction(KeySym k, unsigned vm) const {
+        return WinKeyAction(fWinKeys.find(k, vm));
+    }
+    // after a change of the modifier mapping
+    void regrabMouse();
 
     virtual void handleButton(const XButtonEvent &button);
     virtual void handleClick(const XButtonEvent &up, int count);
@@ -113,6 +175,10 @@ public:
 
     void manageClients();
     void unmanageClients();
+    // keep the order of frames across a restart in _ICEWM_RESTART_STATE
+    void saveRestartState();
+    // apply the task order of before a restart to a new taskbar
+    void restoreTaskOrder();
     void grabServer();
     void ungrabServer();
 
@@ -141,9 +207,10 @@ public:
     void getWorkArea(const YFrameWindow *frame, int *mx, int *my, int *Mx, int *My, int xiscreen = -1);
     void getWorkAreaSize(YFrameWindow *frame, int *Mw,int *Mh);
 
-    int calcCoverage(bool down, YFrameWindow *frame, int x, int y, int w, int h);
-    void tryCover(bool down, YFrameWindow *frame, int x, int y, int w, int h,
-                  int &px, int &py, int &cover, int xiscreen);
+    void addCoverage(bool down, YFrameWindow* frame, YCoverage& coverage);
+    void tryCover(const YCoverage& coverage, const YRect& area,
+                  int x, int y, int w, int h,
+                  int &px, int &py, long long &cover);
     bool getSmartPlace(bool down, YFrameWindow *frame, int &x, int &y, int w, int h, int xiscreen);
     void getNewPosition(YFrameWindow *frame, int &x, int &y, int w, int h, int xiscreen);
     void placeWindow(YFrameWindow *frame, int x, int y, int cw, int ch, bool newClient, bool &canActivate);
@@ -156,6 +223,27 @@ public:
     YFrameWindow *topLayer(long layer = WinLayerCount - 1);
     YFrameWindow *bottomLayer(long layer = 0);
 
+    // the spatial index of frame geometries per workspace
+    void indexFrame(YFrameWindow* frame);
+    void reindexFrame(YFrameWindow* frame, const YRect& old);
+    void unindexFrame(YFrameWindow* frame);
+    // visit the frames on workspace or on all workspaces
+    // whose geometry intersects area
+    template <class Visitor>
+    void visitFrames(const YRect& area, int workspace, Visitor visit) const {
+        if (workspace != AllWorkspaces && workspace + 1 < fFrameIndex.getCount())
+            fFrameIndex[workspace + 1]->visit(area, visit);
+        if (fFrameIndex.getCount())
+            fFrameIndex[0]->visit(area, visit);
+    }
+    void framesAt(const YRect& area, int workspace,
+                  YArray<YFrameWindow*>& found) const {
+        visitFrames(area, workspace,
+                    [&found] (YFrameWindow* f) { found.append(f); });
+    }
+    // position in the stacking order, from zero for the top frame
+    int stackRank(YFrameWindow* frame);
+
     bool setAbove(YFrameWindow* frame, YFrameWindow* above);
     bool setBelow(YFrameWindow* frame, YFrameWindow* below);
     void removeLayeredFrame(YFrameWindow *);
@@ -169,14 +257,28 @@ public:
     void removeFocusFrame(YFrameWindow* frame);
     void lowerFocusFrame(YFrameWindow* frame);
     void raiseFocusFrame(YFrameWindow* frame);
-
-    void restackWindows();
+    void refileFocusFrame(YFrameWindow* frame, int previous);
+    // the frames visible on workspace, by recent focus or top down
+    void focusedOn(long workspace, YArray<YFrameWindow*>& frames);
+    void stackedOn(long workspace, YArray<YFrameWindow*>& frames);
+
+    // restack once the pending events are handled
+    void restackWindows() { fRestackPending = true; }
+    void flushRestack();
+    // parent a frame under the container of its workspace and layer
+    void contain(YFrameWindow* frame);
+    // restack a frame among the frames in the same container
+    void restackContained(YFrameWindow* frame);
+    // update the shapes of containers whose frames have changed
+    void updateContainers();
+    bool containing() const { return fContaining; }
     void focusTopWindow();
     YFrameWindow *getFrameUnderMouse(long workspace = AllWorkspaces);
     YFrameWindow *getLastFocus(bool skipAllWorkspaces = false, long workspace = AllWorkspaces);
     void focusLastWindow();
-    bool focusTop(YFrameWindow *f);
-    void updateClientList();
+    // publish the client lists once the pending events are handled
+    void updateClientList() { fClientListPending = true; }
+    void flushClientList();
     void updateUserTime(const UserTime& userTime);
 
     YMenu *createWindowMenu(YMenu *menu, long workspace);
@@ -252,6 +354,12 @@ public:
 
     void saveArrange(YFrameWindow **w, int count);
     void undoArrange();
+
+    // stage frame geometries and apply them together under a server grab
+    void beginGeometry();
+    void stageGeometry(YFrameWindow* frame, int x, int y, int w, int h);
+    void stagePosition(YFrameWindow* frame, int x, int y);
+    void commitGeometry();
     void arrangeIcons();
 
     bool haveClients();
@@ -306,11 +414,24 @@ private:
         long state;
         YFrameWindow *frame;
     };
+    struct StagedGeometry {
+        YFrameWindow* frame;
+        int x, y, w, h;
+        bool sized;
+    };
+
+    WorkspaceContainer* container(long workspace, long layer);
+    void switchContainers();
 
+    enum { RestartSections = 4 };
+    void restoreRestartState(const long* const* windows, const long* counts);
     void updateArea(long workspace, int screen_number, int l, int t, int r, int b);
     bool handleWMKey(const XKeyEvent &key, KeySym k, unsigned int m, unsigned int vm);
     void setWmState(WMState newWmState);
     void refresh();
+    void publishClientList(const Atom* props, const Atom* types, int count,
+                           YArray<XID>& ids, YArray<XID>& published);
+    void publishClientLists();
 
     IApp *app;
     YActionListener *wmActionListener;
@@ -320,6 +441,10 @@ private:
     YLayeredList fLayers[WinLayerCount];
     YCreatedList fCreationOrder;  // frame creation order
     YFocusedList fFocusedOrder;   // focus order: old -> now
+    YObjectArray<YWorkspaceList> fWorkspaceFocus; // per workspace
+    long fFocusStampLow;          // focus stamps increase with recency
+    long fFocusStampHigh;
+    YArray<Window> fTaskOrder;    // task order before a restart
 
     long fActiveWorkspace;
     long fLastWorkspace;
@@ -349,11 +474,21 @@ private:
             return YRect(fMinX, fMinY, width(), height());
         }
     } **fWorkArea;
+    WorkAreaRect **fSpareWorkArea;  // the previous work area for reuse
+    WorkAreaRect** newWorkArea(long spaces, int screens);
+    static void deleteWorkArea(WorkAreaRect** area);
+    void resizeWindows(WorkAreaRect** oldWorkArea);
 
     YObjectArray<EdgeSwitch> edges;
+    YObjectArray<WorkspaceContainer> fContainers;
+    bool fContaining;
+    bool fRestackPending;
+    // the order of frames below the other windows as last restacked
+    YArray<Window> fStacking;
     bool fShuttingDown;
     int fArrangeCount;
     WindowPosState *fArrangeInfo;
+    YArray<StagedGeometry> fStagedGeometry;
     YProxyWindow *rootProxy;
     YWindow *fTopWin;
     int fIconColumn;
@@ -369,6 +504,17 @@ private:
     bool fShowingDesktop;
     bool fCreatedUpdated;
     bool fLayeredUpdated;
+    bool fClientListPending;
+    bool fClientListPublished;
+    YArray<XID> fPublishedCreated;
+    YArray<XID> fPublishedStacking;
+    bool fStackRanked;
+    YKeyTable fSysKeys;
+    YKeyTable fWinKeys;
+
+    YGrid<YFrameWindow>& frameIndex(int workspace);
+    YObjectArray<YGrid<YFrameWindow>> fFrameIndex;
+    YWorkspaceList& focusedList(long workspace);
 
     DesktopLayout fLayout;
     mstring fCurrentKeyboard;
@@ -405,6 +551,8 @@ extern Atom _XA_ICEWM_ACTION;
 extern Atom _XA_ICEWM_GUIEVENT;
 extern Atom _XA_ICEWM_HINT;
 extern Atom _XA_ICEWM_FONT_PATH;
+extern Atom _XA_ICEWM_EVENT_STATS;
+extern Atom _XA_ICEWM_RESTART_STATE;
 extern Atom _XA_XROOTPMAP_ID;
 extern Atom _XA_XROOTCOLOR_PIXEL;
 
@@ -23,25 +23,74 @@ class WindowItemsCtrlr : public ISwitchItems
     YFrameWindow *fLastWindow;
     char *fWMClass;
 
-    void append(YFrameWindow* w) {
-        if (find(zList, w) < 0) {
-            zList.append(w);
+    enum { Categories = 6 };
+
+    // the category of a frame in the switch list, or -1 to leave it out:
+    // 0 focused, 1 urgent, 2 normal, 3 minimized, 4 hidden, 5 unfocusable
+    int category(YFrameWindow* w) {
+        if (hasbit(w->client()->winHints(), WinHintsSkipFocus))
+            return -1;
+        if (!w->client()->adopted() && !w->shownNow())
+            return -1;
+        if (nonempty(fWMClass)) {
+            if (w->client()->classHint()->match(fWMClass) == false)
+                return -1;
         }
+
+        if (w == fRoot->getFocus())
+            return 0;
+        if (w->isUrgent())
+            return quickSwitchToUrgent ? 1 : 2;
+        if (w->frameOption(YFrameWindow::foIgnoreQSwitch))
+            return -1;
+        if (w->avoidFocus())
+            return 5;
+        if (w->isHidden())
+            return quickSwitchToHidden ? 4 : -1;
+        if (w->isMinimized())
+            return quickSwitchToMinimized ? 3 : -1;
+        return 2;
+    }
+
+    // the workspace group of a frame: the active workspace comes first,
+    // then the others in order, or -1 when it is on none of them
+    int group(YFrameWindow* w, bool workspaceOnly, int active) {
+        if (workspaceOnly == false || w->isUrgent() || w->visibleOn(active))
+            return 0;
+        int ws = w->getWorkspace();
+        if (w->isSticky() || !inrange(ws, 0, workspaceCount - 1))
+            return -1;
+        return ws + (ws < active);
     }
 
     void getZList() {
-
-        if (quickSwitchGroupWorkspaces || !quickSwitchToAllWorkspaces) {
-            int activeWorkspace = fRoot->activeWorkspace();
-            GetZListWorkspace(true, activeWorkspace);
-            if (quickSwitchToAllWorkspaces) {
-                for (int w = 0; w < workspaceCount; ++w) {
-                    if (w != activeWorkspace)
-                        GetZListWorkspace(true, w);
-                }
+        const int active = fRoot->activeWorkspace();
+        const bool workspaceOnly =
+            quickSwitchGroupWorkspaces || !quickSwitchToAllWorkspaces;
+        const int groups =
+            workspaceOnly && quickSwitchToAllWorkspaces ? workspaceCount : 1;
+        const int buckets = groups * Categories;
+
+        // bucket the frames in focus order by group and category
+        YArray<YFrameWindow*> frames(fRoot->focusedCount());
+        YArray<int> keys(fRoot->focusedCount());
+        YArray<int> start;
+        start.extend(buckets + 1);
+        for (YFrameIter w = fRoot->focusedReverseIterator(); ++w; ) {
+            int cat = category(w);
+            int grp = (cat < 0) ? -1 : group(w, workspaceOnly, active);
+            if (inrange(grp, 0, groups - 1)) {
+                int key = grp * Categories + cat;
+                frames.append(w);
+                keys.append(key);
+                start[key + 1] += 1;
             }
-        } else
-            GetZListWorkspace(false, -1);
+        }
+        for (int i = 0; i < buckets; ++i)
+            start[i + 1] += start[i];
+        zList.extend(frames.getCount());
+        for (int i = 0; i < frames.getCount(); ++i)
+            zList[start[keys[i]]++] = frames[i];
 
         if (fActiveWindow != nullptr && find(zList, fActiveWindow) == -1)
             fActiveWindow = nullptr;
@@ -53,68 +102,6 @@ class WindowItemsCtrlr : public ISwitchItems
         zList.clear();
     }
 
-    void GetZListWorkspace(bool workspaceOnly, int workspace)
-    {
-        for (int pass = 0; pass <= 5; pass++) {
-            YFrameIter w = fRoot->focusedReverseIterator();
-
-            while (++w) {
-                // pass 0: focused window
-                // pass 1: urgent windows
-                // pass 2: normal windows
-                // pass 3: minimized windows
-                // pass 4: hidden windows
-                // pass 5: unfocusable windows
-
-                if (hasbit(w->client()->winHints(), WinHintsSkipFocus))
-                    continue;
-
-                if (!w->client()->adopted() && !w->visible()) {
-                    continue;
-                }
-
-                if (!w->isUrgent()) {
-                    if (workspaceOnly && w->isSticky() &&
-                        workspace != fRoot->activeWorkspace()) {
-                        continue;
-                    }
-
-                    if (workspaceOnly && !w->visibleOn(workspace)) {
-                        continue;
-                    }
-                }
-
-                if (nonempty(fWMClass)) {
-                    if (w->client()->classHint()->match(fWMClass) == false)
-                        continue;
-                }
-
-                if (w == fRoot->getFocus()) {
-                    if (pass == 0) append(w);
-                } else if (w->isUrgent()) {
-                    if (quickSwitchToUrgent) {
-                        if (pass == 1) append(w);
-                    } else {
-                        if (pass == 2) append(w);
-                    }
-                } else if (w->frameOption(YFrameWindow::foIgnoreQSwitch)) {
-                } else if (w->avoidFocus()) {
-                    if (pass == 5) append(w);
-                } else if (w->isHidden()) {
-                    if (pass == 4)
-                        if (quickSwitchToHidden)
-                            append(w);
-                } else if (w->isMinimized()) {
-                    if (pass == 3)
-                        if (quickSwitchToMinimized)
-                            append(w);
-                } else {
-                    if (pass == 2) append(w);
-                }
-            }
-        }
-    }
-
     void displayFocusChange(YFrameWindow *frame)  {
         manager->switchFocusTo(frame, false);
     }
@@ -231,7 +218,12 @@ public:
         YFrameWindow* frame = (YFrameWindow*) item;
         if (frame == fLastWindow)
             fLastWindow = nullptr;
-        updateList();
+        int index = find(zList, frame);
+        if (index >= 0) {
+            zList.remove(index);
+            if (index < zTarget)
+                --zTarget;
+        }
         if (frame == fActiveWindow || fActiveWindow == nullptr) {
             zTarget = -1;
             moveTarget(true);
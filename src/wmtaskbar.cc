@@ -986,6 +986,15 @@ void TaskBar::relayoutTasks() {
         taskPane()->relayout();
 }
 
+int TaskBar::tasksPosition(YFrameWindow *w) {
+    return taskPane() ? taskPane()->position(w) : -1;
+}
+
+void TaskBar::moveTasksApp(YFrameWindow *w, int position) {
+    if (taskPane())
+        taskPane()->moveApp(w, position);
+}
+
 void TaskBar::removeTrayApp(YFrameWindow *w) {
     if (windowTrayPane())
         windowTrayPane()->removeApp(w);
@@ -93,6 +93,8 @@ public:
     void removeTasksApp(YFrameWindow *w);
     class TaskBarApp *addTasksApp(YFrameWindow *w);
     void relayoutTasks();
+    int tasksPosition(YFrameWindow *w);
+    void moveTasksApp(YFrameWindow *w, int position);
 
     void popupStartMenu();
     void popupWindowListMenu();
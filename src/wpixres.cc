@@ -6,6 +6,7 @@
 #include "ref.h"
 #include "ypaths.h"
 #include "ymenu.h"
+#include "ytrace.h"
 
 #define extern
 #include "wpixmaps.h"
@@ -130,7 +131,6 @@ static const PixmapResource themePixRes[] = {
     GradientResource(buttonIPixbuf, "buttonI.xpm"),
     GradientResource(buttonAPixbuf, "buttonA.xpm"),
 
-    GradientResource(logoutPixbuf, "logoutbg.xpm"),
     GradientResource(switchbackPixbuf, "switchbg.xpm"),
     GradientResource(listbackPixbuf, "listbg.xpm"),
     GradientResource(dialogbackPixbuf, "dialogbg.xpm"),
@@ -232,7 +232,6 @@ static const PixmapResource themePixRes[] = {
     PixmapResource(menuButton[1], "menuButtonA.xpm"),
     PixmapResource(menuButton[2], "menuButtonO.xpm"),
 
-    PixmapResource(logoutPixmap, "logoutbg.xpm"),
     PixmapResource(switchbackPixmap, "switchbg.xpm"),
     PixmapResource(menubackPixmap, "menubg.xpm"),
     PixmapResource(menuselPixmap, "menusel.xpm"),
@@ -285,6 +284,11 @@ static const PixmapResource taskbar2PixRes[] = {
     PixmapResource(taskbarExpandImage, "expand.xpm"),
 };
 
+static const PixmapResource logoutPixRes[] = {
+    GradientResource(logoutPixbuf, "logoutbg.xpm"),
+    PixmapResource(logoutPixmap, "logoutbg.xpm"),
+};
+
 static const PixmapResource mailboxPixRes[] = {
     PixmapResource(mailPixmap, "mail.xpm"),
     PixmapResource(noMailPixmap, "nomail.xpm"),
@@ -332,9 +336,16 @@ static PixmapsDescription pixdes[] = {
     { themePixRes, ACOUNT(themePixRes), nullptr, true },
     { taskbarPixRes, ACOUNT(taskbarPixRes), "taskbar", true },
     { taskbar2PixRes, ACOUNT(taskbar2PixRes), "taskbar", false },
+};
+
+// Loaded on first use by WPixRes::initPixmaps(PixmapGroup),
+// indexed by PixmapGroup.
+static PixmapsDescription lazydes[] = {
+    { logoutPixRes, ACOUNT(logoutPixRes), nullptr, true },
     { mailboxPixRes, ACOUNT(mailboxPixRes), "mailbox", false },
     { ledclockPixRes, ACOUNT(ledclockPixRes), "ledclock", false },
 };
+static bool lazyLoaded[ACOUNT(lazydes)];
 
 void PixmapsDescription::load(const upath& file, const char *ent) {
     for (int i = 0; i < count(); ++i) {
@@ -413,19 +424,32 @@ static void loadPixmapResources() {
     }
 }
 
+static void loadPixmapResources(PixmapsDescription& des) {
+    ref<YResourcePaths> paths = YResourcePaths::subdirs(null, des.themeOnly);
+    for (int p = 0; p < paths->getCount(); ++p) {
+        des.scan(paths->getPath(p));
+    }
+}
+
+static void freePixmapResources(PixmapsDescription& des) {
+    for (int k = 0; k < des.count(); ++k) {
+        des.pixres[k].reset();
+    }
+}
+
 static void freePixmapResources() {
     for (int i = 0; i < (int) ACOUNT(pixdes); ++i) {
-        for (int k = 0; k < pixdes[i].count(); ++k) {
-            pixdes[i].pixres[k].reset();
+        freePixmapResources(pixdes[i]);
+    }
+    for (int i = 0; i < (int) ACOUNT(lazydes); ++i) {
+        if (lazyLoaded[i]) {
+            freePixmapResources(lazydes[i]);
+            lazyLoaded[i] = false;
         }
     }
 }
 
 static void replicatePixmaps() {
-    if (logoutPixmap != null) {
-        logoutPixmap->replicate(true, false);
-        logoutPixmap->replicate(false, false);
-    }
     if (switchbackPixmap != null) {
         switchbackPixmap->replicate(true, false);
         switchbackPixmap->replicate(false, false);
@@ -615,6 +639,21 @@ void WPixRes::initPixmaps() {
     initPixmapOffsets();
 }
 
+void WPixRes::initPixmaps(PixmapGroup group) {
+    if (lazyLoaded[group] == false) {
+        static const char* const phases[] = {
+            "pixmaps logout", "pixmaps mailbox", "pixmaps ledclock",
+        };
+        YTracePhase phase(phases[group]);
+        lazyLoaded[group] = true;
+        loadPixmapResources(lazydes[group]);
+        if (group == pgLogout && logoutPixmap != null) {
+            logoutPixmap->replicate(true, false);
+            logoutPixmap->replicate(false, false);
+        }
+    }
+}
+
 void WPixRes::freePixmaps() {
     freePixmapResources();
     freePixmapOffsets();
@@ -4,7 +4,11 @@
 class WPixRes {
 public:
 
+    // Rarely used pixmaps are loaded on first use.
+    enum PixmapGroup { pgLogout, pgMailbox, pgLedClock };
+
     static void initPixmaps();
+    static void initPixmaps(PixmapGroup group);
     static void freePixmaps();
 
 };
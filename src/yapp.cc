@@ -16,6 +16,12 @@
 #ifdef USE_SIGNALFD
 #include <sys/signalfd.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_SYS_TIMERFD_H
+#include <sys/timerfd.h>
+#endif
 #include <wordexp.h>
 #include <pwd.h>
 
@@ -29,9 +35,90 @@ void YTrace::show(bool busy, const char* kind, const char* inst) {
     tlog("%s %s: %s", kind, busy ? "open" : "done", inst);
 }
 
+static int phaseFile = -2;
+
+bool YTracePhase::recording() {
+    if (phaseFile == -2) {
+        phaseFile = -1;
+        const char* path = getenv("ICEWM_TRACE_STARTUP");
+        if (nonempty(path)) {
+            // the first process of a session starts the event array
+            const int flags = O_WRONLY | O_APPEND | O_CLOEXEC;
+            int fd = open(path, flags | O_CREAT | O_EXCL, 0644);
+            bool created = (fd >= 0);
+            if (fd == -1 && errno == EEXIST)
+                fd = open(path, flags);
+            if (fd == -1) {
+                fail("%s", path);
+                return false;
+            }
+            char buf[200];
+            int len = snprintf(buf, sizeof buf,
+                "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                "\"args\":{\"name\":\"%s\"}},\n",
+                created ? "[\n" : "", int(getpid()), ApplicationName);
+            if (inrange(len, 1, int(sizeof buf) - 1) &&
+                write(fd, buf, len) == len)
+                phaseFile = fd;
+            else
+                close(fd);
+        }
+    }
+    return phaseFile >= 0;
+}
+
+long long YTracePhase::micros() {
+    timeval now(monotime());
+    return now.tv_sec * 1000000LL + now.tv_usec;
+}
+
+// resident set size in kilobytes, or zero if unknown
+static long residentKB() {
+    long size = 0, resident = 0;
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+        if (fscanf(fp, "%ld %ld", &size, &resident) != 2)
+            resident = 0;
+        fclose(fp);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void YTracePhase::record(const char* name, long long start, long long stop) {
+    if (recording()) {
+        char buf[300];
+        int len = snprintf(buf, sizeof buf,
+            "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+            "\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"rss_kb\":%ld}},\n",
+            name, ApplicationName, start, stop - start,
+            int(getpid()), int(getpid()), residentKB());
+        if (inrange(len, 1, int(sizeof buf) - 1) &&
+            write(phaseFile, buf, len) != len)
+        {
+            close(phaseFile);
+            phaseFile = -1;
+        }
+    }
+}
+
 IApp::~IApp() {}
 IMainLoop::~IMainLoop() {}
 
+// The ready list of one epoll_wait, while it is being dispatched.
+// Nested main loops stack their lists, so that unregisterPoll
+// can clear the entries of a poll which goes away in a callback.
+struct YPollReady {
+    enum { Size = 32 };
+#ifdef HAVE_SYS_EPOLL_H
+    epoll_event events[Size];
+#endif
+    int count;
+    YPollReady* outer;
+
+    explicit YPollReady(YPollReady* next) : count(0), outer(next) { }
+};
+
 void YApplication::initSignals() {
     sigemptyset(&signalMask);
     sigaddset(&signalMask, SIGHUP);
@@ -58,6 +145,68 @@ void YApplication::initSignals() {
     sfd.registerPoll(signalPipe[0]);
 }
 
+void YApplication::initEpoll() {
+#ifdef HAVE_SYS_EPOLL_H
+    fEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (fEpoll == -1)
+        fail("epoll_create1");
+#endif
+}
+
+// With epoll the main loop sleeps until the timerfd expires
+// at the absolute deadline of the most urgent timer.
+// Sampling timers share their deadlines, so this one
+// timer fires once per sampling interval for all applets.
+void YApplication::initTimerFd() {
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_SYS_TIMERFD_H)
+    if (fEpoll >= 0) {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd == -1)
+            fail("timerfd_create");
+        else
+            tfd.registerPoll(fd);
+    }
+#endif
+}
+
+bool YApplication::armTimerFd(const timeval *deadline) {
+#ifdef HAVE_SYS_TIMERFD_H
+    if (tfd.registered() && fEpoll >= 0) {
+        timeval when = deadline ? *deadline : zerotime();
+        if (when == fArmed)
+            return true;
+        itimerspec spec = {};
+        spec.it_value.tv_sec = when.tv_sec;
+        spec.it_value.tv_nsec = when.tv_usec * 1000L;
+        if (timerfd_settime(tfd.fd(), TFD_TIMER_ABSTIME, &spec, nullptr) == 0) {
+            fArmed = when;
+            return true;
+        }
+        fail("timerfd_settime");
+        tfd.closePoll();
+    }
+#endif
+    return false;
+}
+
+void YTimerPoll::notifyRead() {
+    unsigned long long expirations;
+    if (read(fd(), &expirations, sizeof expirations) > 0) {
+        owner()->fArmed = zerotime();
+        owner()->handleTimeouts();
+    }
+}
+
+void YApplication::countWakeup(const timeval& now) {
+    ++fWakeups;
+    if (fWakeupMinute + 60 <= now.tv_sec) {
+        if (fWakeupMinute && YTrace::traces("wakeup"))
+            tlog("%d wakeups per minute", fWakeups);
+        fWakeupMinute = now.tv_sec;
+        fWakeups = 0;
+    }
+}
+
 #ifdef __linux__
 void alrm_handler(int /*sig*/) {
     show_backtrace();
@@ -66,6 +215,12 @@ void alrm_handler(int /*sig*/) {
 
 YApplication::YApplication(int * /*argc*/, char *** /*argv*/) :
     sfd(this),
+    fEpoll(-1),
+    fReady(nullptr),
+    tfd(this),
+    fArmed(zerotime()),
+    fWakeups(0),
+    fWakeupMinute(0),
     fLoopLevel(0),
     fExitCode(0),
     fExitLoop(false),
@@ -76,128 +231,138 @@ YApplication::YApplication(int * /*argc*/, char *** /*argv*/) :
     setvbuf(stdout, nullptr, _IOLBF, BUFSIZ);
     setvbuf(stderr, nullptr, _IOLBF, BUFSIZ);
 
+    initEpoll();
+    initTimerFd();
     initSignals();
 }
 
 YApplication::~YApplication() {
     sfd.unregisterPoll();
+    tfd.closePoll();
+    if (fEpoll >= 0) {
+        close(fEpoll);
+        fEpoll = -1;
+    }
     if (::mainLoop == this)
         ::mainLoop = nullptr;
 }
 
 void YApplication::registerTimer(YTimer *t) {
-    if (find(timers, t) < 0)
-        timers.append(t);
+    if (timers.contains(t))
+        timers.update(t);
+    else
+        timers.insert(t);
 }
 
 void YApplication::unregisterTimer(YTimer *t) {
-    int k = find(timers, t);
-    if (k >= 0)
-        timers.remove(k);
+    if (timers.contains(t))
+        timers.remove(t);
 }
 
 bool YApplication::nextTimeout(timeval *timeout) {
-    bool fFirst = true;
-    YArrayIterator<YTimer*> t = timers.iterator();
-    while (++t) {
-        if (t->isRunning() && (fFirst || t->timeout < *timeout)) {
-            *timeout = t->timeout;
-            fFirst = false;
-        }
-    }
-    return fFirst == false;
-}
-
-bool YApplication::nextTimeoutWithFuzziness(timeval *timeout) {
-    bool fixedExists = false;
-    timeval timeout_fixed = {0, 0L};
-
-    bool fuzzyExists = false;
-    timeval timeout_fuzzy = {0, 0L};
-    timeval timeout_max = {0, 0L};
-
-    for (YArrayIterator<YTimer*> iter = timers.iterator(); ++iter; ) {
-        if (iter->isRunning()) {
-            if (iter->isFixed()) {
-                // Update if no fixed timer yet or current
-                // is earlier than previously registered one.
-                if (false == fixedExists || iter->timeout < timeout_fixed) {
-                    timeout_fixed = iter->timeout;
-                    fixedExists = true;
-                }
-            }
-            else if (false == fuzzyExists) {
-                // encountered first fuzzy timer, register everything
-                timeout_fuzzy = iter->timeout;
-                timeout_max = iter->timeout_max;
-                fuzzyExists = true;
-            }
-            else if (iter->timeout < timeout_fuzzy) {
-                // this fuzzy timer is earlier than previous one
-                timeout_fuzzy = iter->timeout;
-                if (iter->timeout_max < timeout_max)
-                    timeout_max = iter->timeout_max;
-            }
-        }
-    }
-
-    if (fixedExists && fuzzyExists)
-        *timeout = min(timeout_max, timeout_fixed);
-    else if (fixedExists)
-        *timeout = timeout_fixed;
-    else if (fuzzyExists)
-        *timeout = timeout_max;
-    return fixedExists | fuzzyExists;
-}
-
-bool YApplication::getTimeout(timeval *timeout) {
-    bool found = false;
-    if (0 < timers.getCount()) {
-        timeval tval = {0, 0L};
-        if (inrange(DelayFuzziness, 1, 100))
-            found = nextTimeoutWithFuzziness(&tval);
-        else
-            found = nextTimeout(&tval);
-        if (found)
-            *timeout = max(tval - monotime(), (timeval) { 0L, 1L });
-    }
+    // Fixed timers have equal earliest and latest expiry.
+    // Fuzzy timers may be postponed until the latest expiry
+    // of the most urgent timer, which merges their wakeups.
+    if (timers.isEmpty())
+        return false;
+    *timeout = timers.urgent()->timeout_max;
+    return true;
+}
+
+bool YApplication::getTimeout(timeval *timeout, timeval *deadline) {
+    bool found = nextTimeout(deadline);
+    if (found)
+        *timeout = max(*deadline - monotime(), (timeval) { 0L, 1L });
     return found;
 }
 
 void YApplication::handleTimeouts() {
     timeval now = monotime();
-    YTimer *timeout = nullptr;
-    YArrayIterator<YTimer*> iter = timers.reverseIterator();
-    // we must be careful since the callback may modify the array.
-    while (iter.hasNext()) {
-        if (++iter &&
-            *iter != timeout &&
-            iter->isRunning() &&
-            iter->timeout_min < now)
-        {
-            timeout = *iter;
-            YTimerListener *listener = timeout->getTimerListener();
-            timeout->stopTimer();
-            if (listener && listener->handleTimer(timeout))
-                timeout->startTimer();
-        }
+    // The callback may start and stop timers, but a restarted
+    // timer expires after now, so this loop must terminate.
+    while (timers.nonempty() && timers.earliest()->timeout_min < now) {
+        YTimer *timeout = timers.earliest();
+        YTimerListener *listener = timeout->getTimerListener();
+        timeout->stopTimer();
+        if (listener && listener->handleTimer(timeout))
+            timeout->startTimer();
     }
 }
 
 void YApplication::decreaseTimeouts(timeval diff) {
-    YArrayIterator<YTimer*> iter = timers.reverseIterator();
-    while (++iter)
-        iter->timeout += diff;
+    for (int i = 0; i < timers.getCount(); ++i)
+        timers[i]->timeout += diff;
 }
 
 void YApplication::registerPoll(YPollBase *t) {
     PRECONDITION(t->fd() >= 0);
     if (find(polls, t) < 0)
         polls.append(t);
+    updatePoll(t);
 }
 
 void YApplication::unregisterPoll(YPollBase *t) {
     findRemove(polls, t);
+    updateEpoll(t, 0);
+    for (YPollReady* ready = fReady; ready; ready = ready->outer) {
+#ifdef HAVE_SYS_EPOLL_H
+        for (int i = 0; i < ready->count; ++i) {
+            if (ready->events[i].data.ptr == t)
+                ready->events[i].data.ptr = nullptr;
+        }
+#endif
+    }
+}
+
+void YApplication::updatePoll(YPollBase *t) {
+#ifdef HAVE_SYS_EPOLL_H
+    unsigned events = 0;
+    if (t->forRead())
+        events |= EPOLLIN;
+    if (t->forWrite())
+        events |= EPOLLOUT;
+    updateEpoll(t, events);
+#endif
+}
+
+// Keep the kernel interest set in step with a poll.
+// A poll without interest is removed, because epoll
+// would otherwise still report hangups and errors.
+void YApplication::updateEpoll(YPollBase *t, unsigned events) {
+#ifdef HAVE_SYS_EPOLL_H
+    if (fEpoll >= 0 && events != t->fEvents) {
+        epoll_event ev = {};
+        ev.events = events;
+        ev.data.ptr = t;
+        int op = events == 0 ? EPOLL_CTL_DEL
+               : t->fEvents == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        if (epoll_ctl(fEpoll, op, t->fd(), &ev) == -1 && op != EPOLL_CTL_DEL) {
+            // not every file type can be polled: revert to select
+            fail("epoll_ctl %d for fd %d", op, t->fd());
+            close(fEpoll);
+            fEpoll = -1;
+        }
+        t->fEvents = events;
+    }
+#endif
+}
+
+void YApplication::handleEpoll(YPollReady& ready, int count) {
+#ifdef HAVE_SYS_EPOLL_H
+    ready.count = count;
+    for (int i = 0; i < ready.count; ++i) {
+        const unsigned revents = ready.events[i].events;
+        const unsigned errors = EPOLLERR | EPOLLHUP;
+        YPollBase* poll = static_cast<YPollBase *>(ready.events[i].data.ptr);
+        if (poll && (revents & (EPOLLIN | errors)) && poll->forRead()) {
+            poll->notifyRead();
+            poll = static_cast<YPollBase *>(ready.events[i].data.ptr);
+        }
+        if (poll && (revents & (EPOLLOUT | errors)) && poll->forWrite()) {
+            poll->notifyWrite();
+        }
+    }
+#endif
 }
 
 YPollBase::~YPollBase() {
@@ -212,13 +377,18 @@ void YPollBase::unregisterPoll() {
 }
 
 void YPollBase::registerPoll(int fd) {
+    if (fd != fFd)
+        unregisterPoll();
     fFd = fd;
     if (fFd < 0) {
         unregisterPoll();
     }
     else if (fRegistered == false) {
-        mainLoop->registerPoll(this);
         fRegistered = true;
+        mainLoop->registerPoll(this);
+    }
+    else {
+        mainLoop->updatePoll(this);
     }
 }
 
@@ -246,26 +416,41 @@ int YApplication::mainLoop() {
         fd_set write_fds;
         FD_ZERO(&write_fds);
 
-        for (YPollIterType iPoll = polls.iterator(); ++iPoll; ) {
-            PRECONDITION(iPoll->fd() >= 0);
-            if (iPoll->forRead()) {
-                FD_SET(iPoll->fd(), &read_fds);
-            }
-            if (iPoll->forWrite()) {
-                FD_SET(iPoll->fd(), &write_fds);
+        if (fEpoll < 0) {
+            for (YPollIterType iPoll = polls.iterator(); ++iPoll; ) {
+                PRECONDITION(iPoll->fd() >= 0);
+                if (iPoll->forRead()) {
+                    FD_SET(iPoll->fd(), &read_fds);
+                }
+                if (iPoll->forWrite()) {
+                    FD_SET(iPoll->fd(), &write_fds);
+                }
             }
         }
 
         timeval timeout = {0, 0L};
+        timeval deadline = {0, 0L};
         timeval *tp = &timeout;
-        if (!didIdle && getTimeout(tp) == false)
+        if (!didIdle && getTimeout(tp, &deadline) == false)
             tp = nullptr;
 
+        YPollReady ready(fReady);
+
 #ifndef USE_SIGNALFD
         sigprocmask(SIG_UNBLOCK, &signalMask, nullptr);
 #endif
 
         int rc;
+#ifdef HAVE_SYS_EPOLL_H
+        if (fEpoll >= 0) {
+            int ms = tp == nullptr ? -1 :
+                int(tp->tv_sec * 1000L + (tp->tv_usec + 999L) / 1000L);
+            if (didIdle == false && armTimerFd(tp ? &deadline : nullptr))
+                ms = -1;
+            rc = epoll_wait(fEpoll, ready.events, YPollReady::Size, ms);
+        }
+        else
+#endif
         rc = select(sizeof(fd_set) * 8,
                     SELECT_TYPE_ARG234 &read_fds,
                     SELECT_TYPE_ARG234 &write_fds,
@@ -288,12 +473,18 @@ int YApplication::mainLoop() {
             }
             prevtime += diff;
         }
+        if (didIdle == false)
+            countWakeup(prevtime);
 
         if (rc == 0) {
             handleTimeouts();
         } else if (rc == -1) {
             if (errno != EINTR)
                 fail(_("%s: select failed"), __func__);
+        } else if (fEpoll >= 0) {
+            fReady = &ready;
+            handleEpoll(ready, rc);
+            fReady = ready.outer;
         } else {
             for (YPollIterType iPoll = polls.reverseIterator(); ++iPoll; ) {
                 if (iPoll->fd() >= 0 && FD_ISSET(iPoll->fd(), &read_fds)) {
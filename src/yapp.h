@@ -4,9 +4,45 @@
 #include "upath.h"
 #include "yarray.h"
 #include "ypoll.h"
+#include "ytimer.h"
 #include "ytrace.h"
 
-class YTimer;
+// The running timers, kept in two indexed binary heaps:
+// one ordered by the earliest and one by the latest expiry.
+// The latest expiry of the urgent timer is when the main loop
+// must wake up; then all timers past their earliest expiry
+// are due, which coalesces timers with DelayFuzziness.
+class YTimerQueue {
+public:
+    bool isEmpty() const { return fHeap[Max].isEmpty(); }
+    bool nonempty() const { return fHeap[Max].nonempty(); }
+    bool contains(const YTimer *t) const { return t->fIndex[Max] >= 0; }
+
+    void insert(YTimer *t);
+    void remove(YTimer *t);
+    void update(YTimer *t);
+
+    YTimer* earliest() const { return fHeap[Min][0]; }
+    YTimer* urgent() const { return fHeap[Max][0]; }
+
+    int getCount() const { return fHeap[Max].getCount(); }
+    YTimer* operator[](int i) const { return fHeap[Max][i]; }
+
+private:
+    enum { Min, Max };
+    YArray<YTimer*> fHeap[2];
+
+    static bool before(int k, const YTimer *a, const YTimer *b) {
+        return k == Min ? a->timeout_min < b->timeout_min
+                        : a->timeout_max < b->timeout_max;
+    }
+    void place(int k, int i, YTimer *t) {
+        fHeap[k][i] = t;
+        t->fIndex[k] = i;
+    }
+    void siftUp(int k, int i);
+    void siftDown(int k, int i);
+};
 
 class YSignalPoll: public YPoll<class YApplication> {
 public:
@@ -15,6 +51,13 @@ public:
     virtual bool forRead() { return true; }
 };
 
+class YTimerPoll: public YPoll<class YApplication> {
+public:
+    explicit YTimerPoll(YApplication* owner) : YPoll(owner) { }
+    virtual void notifyRead();
+    virtual bool forRead() { return true; }
+};
+
 class IApp {
 public:
     virtual ~IApp();
@@ -32,6 +75,7 @@ public:
     virtual void unregisterTimer(YTimer *t) = 0;
     virtual void registerPoll(YPollBase *t) = 0;
     virtual void unregisterPoll(YPollBase *t) = 0;
+    virtual void updatePoll(YPollBase *t) = 0;
 };
 
 class YApplication: public IApp, public IMainLoop {
@@ -62,24 +106,40 @@ public:
     static upath getHomeDir();
 
 private:
-    YArray<YTimer*> timers;
+    YTimerQueue timers;
     YArray<YPollBase*> polls;
     typedef YArray<YPollBase*>::IterType YPollIterType;
 
     YSignalPoll sfd;
     friend class YSignalPoll;
 
+    int fEpoll;
+    struct YPollReady* fReady;
+
+    YTimerPoll tfd;
+    friend class YTimerPoll;
+    timeval fArmed;
+
+    int fWakeups;
+    long fWakeupMinute;
+
     int fLoopLevel;
     int fExitCode;
     bool fExitLoop;
     bool fExitApp;
 
-    bool getTimeout(struct timeval *timeout);
+    bool getTimeout(struct timeval *timeout, struct timeval *deadline);
     void handleTimeouts();
     void decreaseTimeouts(struct timeval difftime);
 
     void handleSignalPipe();
     void initSignals();
+    void initEpoll();
+    void initTimerFd();
+    bool armTimerFd(const timeval *deadline);
+    void countWakeup(const timeval& now);
+    void updateEpoll(YPollBase *t, unsigned events);
+    void handleEpoll(YPollReady& ready, int count);
 
 protected:
     friend class YTimer;
@@ -88,9 +148,9 @@ protected:
     virtual void registerTimer(YTimer *t);
     virtual void unregisterTimer(YTimer *t);
     bool nextTimeout(struct timeval *timeout);
-    bool nextTimeoutWithFuzziness(struct timeval *timeout);
     virtual void registerPoll(YPollBase *t);
     virtual void unregisterPoll(YPollBase *t);
+    virtual void updatePoll(YPollBase *t);
 
 protected:
     virtual void flushXEvents() {}
@@ -233,8 +233,7 @@ bool YButton::handleKey(const XKeyEvent &key) {
                     // !!! is this guaranteed to work? (skip autorepeated keys)
                     XEvent xev = {};
 
-                    if (XCheckTypedWindowEvent(xapp->display(), handle(),
-                                               KeyPress, &xev) &&
+                    if (xapp->checkWindowEvent(handle(), KeyPress, &xev) &&
                         xev.type == KeyPress &&
                         xev.xkey.time == key.time &&
                         xev.xkey.keycode == key.keycode &&
@@ -0,0 +1,131 @@
+/*
+ * IceWM - summed-area table of weighted rectangles
+ */
+#include "config.h"
+#include "ycover.h"
+#include "base.h"
+
+YCoverage::YCoverage(const YRect& bounds) :
+    fX1(bounds.x()),
+    fY1(bounds.y()),
+    fX2(bounds.x() + int(bounds.width())),
+    fY2(bounds.y() + int(bounds.height())),
+    fXcell(nullptr),
+    fYcell(nullptr),
+    fSums(nullptr)
+{
+}
+
+YCoverage::~YCoverage() {
+    delete[] fXcell;
+    delete[] fYcell;
+    delete[] fSums;
+}
+
+void YCoverage::add(const YRect& rect, int weight) {
+    const Rect r = {
+        max(rect.x(), fX1),
+        max(rect.y(), fY1),
+        min(rect.x() + int(rect.width()), fX2),
+        min(rect.y() + int(rect.height()), fY2),
+        weight,
+    };
+    if (r.x1 < r.x2 && r.y1 < r.y2 && weight)
+        fRects.append(r);
+}
+
+// collect the distinct marked offsets as edges
+// and map every offset to the index of the last edge not after it
+static void compress(int lo, int* cells, int count, YArray<int>& edges) {
+    for (int k = 0; k < count; ++k) {
+        if (cells[k])
+            edges.append(lo + k);
+        cells[k] = edges.getCount() - 1;
+    }
+}
+
+void YCoverage::build() {
+    const int width = fX2 - fX1 + 1, height = fY2 - fY1 + 1;
+    const int count = fRects.getCount();
+    fXcell = new int[width]();
+    fYcell = new int[height]();
+    fXcell[0] = fXcell[width - 1] = 1;
+    fYcell[0] = fYcell[height - 1] = 1;
+    for (int k = 0; k < count; ++k) {
+        const Rect& r(fRects[k]);
+        fXcell[r.x1 - fX1] = fXcell[r.x2 - fX1] = 1;
+        fYcell[r.y1 - fY1] = fYcell[r.y2 - fY1] = 1;
+    }
+    compress(fX1, fXcell, width, fXs);
+    compress(fY1, fYcell, height, fYs);
+
+    // rasterize the weights as differences at the corners
+    const int nx = fXs.getCount(), ny = fYs.getCount();
+    fSums = new long long[nx * ny]();
+    for (int k = 0; k < count; ++k) {
+        const Rect& r(fRects[k]);
+        const int i1 = fXcell[r.x1 - fX1], i2 = fXcell[r.x2 - fX1];
+        const int j1 = fYcell[r.y1 - fY1], j2 = fYcell[r.y2 - fY1];
+        sum(i1, j1) += r.weight;
+        sum(i2, j1) -= r.weight;
+        sum(i1, j2) -= r.weight;
+        sum(i2, j2) += r.weight;
+    }
+
+    // accumulate the differences into the density of each cell,
+    // weigh it by the cell area and accumulate again into integrals
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int j = 0; j < ny; ++j) {
+            for (int i = 0; i < nx; ++i) {
+                if (pass && i + 1 < nx && j + 1 < ny)
+                    sum(i, j) *= (fXs[i + 1] - fXs[i]) *
+                                 (long long) (fYs[j + 1] - fYs[j]);
+                if (i)
+                    sum(i, j) += sum(i - 1, j);
+                if (j)
+                    sum(i, j) += sum(i, j - 1);
+                if (i && j)
+                    sum(i, j) -= sum(i - 1, j - 1);
+            }
+        }
+    }
+    // an integral up to an edge excludes the cells from that edge on
+    for (int j = ny - 1; 0 <= j; --j)
+        for (int i = nx - 1; 0 <= i; --i)
+            sum(i, j) = (i && j) ? sum(i - 1, j - 1) : 0;
+
+    fRects.clear();
+}
+
+long long YCoverage::integral(int x, int y) const {
+    x = clamp(x, fX1, fX2);
+    y = clamp(y, fY1, fY2);
+    const int i = fXcell[x - fX1], j = fYcell[y - fY1];
+    const long long dx = x - fXs[i], dy = y - fYs[j];
+    const long long s = sum(i, j);
+    long long result = s;
+
+    // within a cell the density is constant, hence
+    // the integral is bilinear and all divisions are exact
+    if (dx) {
+        result += (sum(i + 1, j) - s) / (fXs[i + 1] - fXs[i]) * dx;
+    }
+    if (dy) {
+        result += (sum(i, j + 1) - s) / (fYs[j + 1] - fYs[j]) * dy;
+    }
+    if (dx && dy) {
+        long long d = sum(i + 1, j + 1) - sum(i + 1, j) - sum(i, j + 1) + s;
+        result += d / ((fXs[i + 1] - fXs[i]) *
+                       (long long) (fYs[j + 1] - fYs[j])) * dx * dy;
+    }
+    return result;
+}
+
+long long YCoverage::coverage(const YRect& area) const {
+    const int x2 = area.x() + int(area.width());
+    const int y2 = area.y() + int(area.height());
+    return integral(x2, y2) - integral(area.x(), y2)
+         - integral(x2, area.y()) + integral(area.x(), area.y());
+}
+
+// vim: set sw=4 ts=4 et:
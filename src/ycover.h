@@ -0,0 +1,49 @@
+#ifndef YCOVER_H
+#define YCOVER_H
+
+#include "yarray.h"
+#include "yrect.h"
+
+// The weighted coverage of areas by a set of rectangles within bounds.
+// After all rectangles are added, build rasterizes them once over the
+// compressed coordinates of their edges into a summed-area table.
+// Then the coverage of any area costs a constant number of lookups.
+class YCoverage {
+public:
+    explicit YCoverage(const YRect& bounds);
+    ~YCoverage();
+
+    void add(const YRect& rect, int weight);
+    void build();
+
+    // the sum of weight times overlap with area over all rectangles
+    long long coverage(const YRect& area) const;
+
+private:
+    struct Rect {
+        int x1, y1, x2, y2, weight;
+    };
+
+    // the coverage of everything left of x and above y
+    long long integral(int x, int y) const;
+    long long& sum(int i, int j) const {
+        return fSums[j * fXs.getCount() + i];
+    }
+
+    const int fX1, fY1, fX2, fY2;
+    YArray<Rect> fRects;
+    // the distinct edges in ascending order
+    YArray<int> fXs, fYs;
+    // for each pixel offset the index of the last edge not after it
+    int* fXcell;
+    int* fYcell;
+    // the coverage above and left of each pair of edges
+    long long* fSums;
+
+    YCoverage(const YCoverage&);
+    YCoverage& operator=(const YCoverage&);
+};
+
+#endif
+
+// vim: set sw=4 ts=4 et:
@@ -0,0 +1,145 @@
+/*
+ * IceWM - dispatch latency histograms for X events
+ */
+#include "config.h"
+#include "yevstats.h"
+#include "ywindow.h"
+#include "base.h"
+#include <typeinfo>
+
+YEventStats::YEventStats() :
+    fSince(monotime()),
+    fTarget(nullptr)
+{
+}
+
+YEventStats::Histogram::Histogram() :
+    count(0), total(0), longest(0)
+{
+    for (int i = 0; i < Buckets; ++i)
+        bucket[i] = 0;
+}
+
+void YEventStats::Histogram::add(unsigned long usec) {
+    int k = 0;
+    while (k + 1 < Buckets && (usec >> k))
+        ++k;
+    bucket[k] += 1;
+    count += 1;
+    total += usec;
+    if (longest < usec)
+        longest = usec;
+}
+
+unsigned long YEventStats::Histogram::percentile(int percent) const {
+    unsigned long need = (count * percent + 99) / 100, seen = 0;
+    for (int k = 0; k < Buckets; ++k) {
+        seen += bucket[k];
+        if (seen >= need && seen)
+            return min(longest, (1UL << k) - 1UL);
+    }
+    return longest;
+}
+
+const char* YEventStats::className(YWindow* window) {
+    return typeid(*window).name();
+}
+
+void YEventStats::leave(int type, const timeval& start, const char* outer) {
+    timeval spent(monotime() - start);
+    unsigned long usec = spent.tv_sec * 1000000L + spent.tv_usec;
+
+    fTypes[inrange(type, 0, LASTEvent - 1) ? type : Extension].add(usec);
+
+    const char* name = fTarget ? fTarget : "";
+    Target* target = nullptr;
+    for (int i = 0; i < fTargets.getCount(); ++i) {
+        if (fTargets[i]->name == name) {
+            target = fTargets[i];
+            break;
+        }
+    }
+    if (target == nullptr) {
+        target = new Target(name);
+        fTargets.append(target);
+    }
+    target->hist.add(usec);
+
+    fTarget = outer;
+}
+
+mstring YEventStats::line(const char* name, const Histogram& hist) {
+    char buf[200];
+    snprintf(buf, sizeof buf, "%-26.26s %8lu %8lu %7lu %7lu %7lu %8lu\n",
+             name, hist.count, hist.total / max(1UL, hist.count),
+             hist.percentile(50), hist.percentile(90),
+             hist.percentile(99), hist.longest);
+    return buf;
+}
+
+static int compareTotal(unsigned long t1, unsigned long t2) {
+    return (t1 < t2) - (t2 < t1);
+}
+
+int YEventStats::compareTypes(const void* p1, const void* p2) {
+    const Histogram* h1 = *static_cast<const Histogram* const *>(p1);
+    const Histogram* h2 = *static_cast<const Histogram* const *>(p2);
+    return compareTotal(h1->total, h2->total);
+}
+
+int YEventStats::compareTargets(const void* p1, const void* p2) {
+    const Target* t1 = *static_cast<const Target* const *>(p1);
+    const Target* t2 = *static_cast<const Target* const *>(p2);
+    return compareTotal(t1->hist.total, t2->hist.total);
+}
+
+mstring YEventStats::heading(const char* title) {
+    char buf[200];
+    snprintf(buf, sizeof buf, "\n%-26s %8s %8s %7s %7s %7s %8s\n",
+             title, "count", "avg us", "p50 us", "p90 us", "p99 us", "max us");
+    return buf;
+}
+
+mstring YEventStats::report() const {
+    char buf[80];
+    timeval spent(monotime() - fSince);
+    snprintf(buf, sizeof buf, "Event dispatch over %ld seconds\n",
+             long(spent.tv_sec));
+
+    mstring text(buf);
+    text += heading("Event type");
+
+    const Histogram* types[Types];
+    int count = 0;
+    for (int i = 0; i < Types; ++i)
+        if (fTypes[i].count)
+            types[count++] = &fTypes[i];
+    qsort(types, count, sizeof types[0], compareTypes);
+    for (int i = 0; i < count; ++i) {
+        int type = int(types[i] - fTypes);
+        text += line(type == Extension ? "Extension" : eventName(type),
+                     *types[i]);
+    }
+
+    text += heading("Target class");
+
+    count = fTargets.getCount();
+    const Target** targets = new const Target*[max(1, count)];
+    for (int i = 0; i < count; ++i)
+        targets[i] = fTargets[i];
+    qsort(targets, count, sizeof targets[0], compareTargets);
+    for (int i = 0; i < count; ++i) {
+        const char* name = targets[i]->name;
+        if (*name) {
+            char* demangled = demangle(name);
+            text += line(demangled, targets[i]->hist);
+            free(demangled);
+        } else {
+            text += line("(none)", targets[i]->hist);
+        }
+    }
+    delete[] targets;
+    return text;
+}
+
+// vim: set sw=4 ts=4 et:
@@ -0,0 +1,66 @@
+#ifndef YEVSTATS_H
+#define YEVSTATS_H
+
+#include <X11/X.h>
+#include "mstring.h"
+#include "yarray.h"
+#include "ytime.h"
+
+class YWindow;
+
+// Dispatch latency of X events, per event type and per target class,
+// kept in log-scale histograms of microseconds.
+class YEventStats {
+public:
+    YEventStats();
+
+    // begin dispatching an event, returns the target of an outer event
+    const char* enter() {
+        const char* outer = fTarget;
+        fTarget = nullptr;
+        return outer;
+    }
+    // the first window to receive the event is taken as its target
+    void target(YWindow* window) {
+        if (fTarget == nullptr && window)
+            fTarget = className(window);
+    }
+    // record the dispatch time of an event since start
+    void leave(int type, const timeval& start, const char* outer);
+
+    mstring report() const;
+
+private:
+    enum { Buckets = 22, Extension = LASTEvent, Types };
+
+    struct Histogram {
+        unsigned long count;
+        unsigned long total;
+        unsigned long longest;
+        unsigned long bucket[Buckets];
+
+        Histogram();
+        void add(unsigned long usec);
+        unsigned long percentile(int percent) const;
+    };
+    struct Target {
+        const char* name;
+        Histogram hist;
+        Target(const char* name) : name(name) { }
+    };
+
+    static const char* className(YWindow* window);
+    static mstring line(const char* name, const Histogram& hist);
+    static mstring heading(const char* title);
+    static int compareTypes(const void* p1, const void* p2);
+    static int compareTargets(const void* p1, const void* p2);
+
+    timeval fSince;
+    const char* fTarget;
+    Histogram fTypes[Types];
+    YObjectArray<Target> fTargets;
+};
+
+#endif
+
+// vim: set sw=4 ts=4 et:
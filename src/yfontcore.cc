@@ -95,6 +95,7 @@ int YCoreFont::textWidth(const char *str, int len) const {
 void YCoreFont::drawGlyphs(Graphics & graphics, int x, int y,
                            char const * str, int len) {
     XSetFont(xapp->display(), graphics.handleX(), fFont->fid);
+    graphics.referGC(GCFont);
     XDrawString(xapp->display(), graphics.drawable(), graphics.handleX(),
                 x - graphics.xorigin(), y - graphics.yorigin(), str, len);
 }
@@ -162,6 +163,7 @@ void YFontSet::drawGlyphs(Graphics & graphics, int x, int y,
     XmbDrawString(xapp->display(), graphics.drawable(),
                   fFontSet, graphics.handleX(),
                   x - graphics.xorigin(), y - graphics.yorigin(), str, len);
+    graphics.referGC(GCFont);
 }
 
 XFontSet YFontSet::getFontSetWithGuess(char const * pattern, char *** missing,
@@ -0,0 +1,88 @@
+/*
+ * IceWM - uniform grid index of rectangles
+ */
+#include "config.h"
+#include "ygrid.h"
+
+YAnyGrid::YAnyGrid(unsigned cellSize) :
+    fCells(new Cell[1]),
+    fColumns(1),
+    fRows(1),
+    fSize(max(1U, cellSize)),
+    fCount(0)
+{
+}
+
+YAnyGrid::~YAnyGrid() {
+    delete[] fCells;
+}
+
+void YAnyGrid::insert(AnyPointer item, const YRect& rect) {
+    const Entry entry = {
+        item, rect,
+        rect.x() + int(rect.width()), rect.y() + int(rect.height())
+    };
+    const int c2 = column(rect.x() + int(max(1U, rect.width())) - 1);
+    const int r2 = row(rect.y() + int(max(1U, rect.height())) - 1);
+    for (int r = row(rect.y()); r <= r2; ++r)
+        for (int c = column(rect.x()); c <= c2; ++c)
+            cell(c, r).append(entry);
+    fCount++;
+}
+
+bool YAnyGrid::remove(AnyPointer item, const YRect& rect) {
+    bool found = false;
+    const int c2 = column(rect.x() + int(max(1U, rect.width())) - 1);
+    const int r2 = row(rect.y() + int(max(1U, rect.height())) - 1);
+    for (int r = row(rect.y()); r <= r2; ++r) {
+        for (int c = column(rect.x()); c <= c2; ++c) {
+            Cell& list(cell(c, r));
+            for (int i = list.getCount(); 0 <= --i; ) {
+                if (list[i].item == item && list[i].rect == rect) {
+                    list.remove(i);
+                    found = true;
+                    break;
+                }
+            }
+        }
+    }
+    if (found)
+        fCount--;
+    return found;
+}
+
+void YAnyGrid::resize(unsigned width, unsigned height) {
+    const int columns = max(1, int((width + fSize - 1) / fSize));
+    const int rows = max(1, int((height + fSize - 1) / fSize));
+    if (columns == fColumns && rows == fRows)
+        return;
+
+    // collect every entry once, from the cell of its top left corner
+    YArray<Entry> entries;
+    for (int r = 0; r < fRows; ++r) {
+        for (int c = 0; c < fColumns; ++c) {
+            const Cell& list(cell(c, r));
+            for (int i = 0; i < list.getCount(); ++i) {
+                if (column(list[i].rect.x()) == c &&
+                    row(list[i].rect.y()) == r)
+                    entries.append(list[i]);
+            }
+        }
+    }
+
+    delete[] fCells;
+    fCells = new Cell[columns * rows];
+    fColumns = columns;
+    fRows = rows;
+    fCount = 0;
+    for (int i = 0; i < entries.getCount(); ++i)
+        insert(entries[i].item, entries[i].rect);
+}
+
+void YAnyGrid::clear() {
+    for (int i = 0; i < fColumns * fRows; ++i)
+        fCells[i].clear();
+    fCount = 0;
+}
+
+// vim: set sw=4 ts=4 et:
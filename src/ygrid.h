@@ -0,0 +1,116 @@
+#ifndef YGRID_H
+#define YGRID_H
+
+#include "yarray.h"
+#include "yrect.h"
+
+// Index rectangles by the cells of a uniform grid which they overlap,
+// to find those which intersect an area without looking at all others.
+// Rectangles beyond the grid area are kept in the cells of its border.
+class YAnyGrid {
+protected:
+    typedef void* AnyPointer;
+
+    explicit YAnyGrid(unsigned cellSize);
+    ~YAnyGrid();
+
+    // add an item with its rectangle
+    void insert(AnyPointer item, const YRect& rect);
+    // remove an item which was added with this rectangle
+    bool remove(AnyPointer item, const YRect& rect);
+
+    // call visit for each item whose rectangle intersects area
+    template <class Visitor>
+    void visitAny(const YRect& area, Visitor& visit) const {
+        if (area.width() == 0 || area.height() == 0)
+            return;
+        const int x2 = area.x() + int(area.width());
+        const int y2 = area.y() + int(area.height());
+        const int c1 = column(area.x()), c2 = column(x2 - 1);
+        const int r1 = row(area.y()), r2 = row(y2 - 1);
+        for (int r = r1; r <= r2; ++r) {
+            for (int c = c1; c <= c2; ++c) {
+                const Cell& list(cell(c, r));
+                const int count = list.getCount();
+                for (int i = 0; i < count; ++i) {
+                    const Entry& e(list[i]);
+                    // report an item only in the cell of the top left
+                    // corner of its intersection with the area
+                    if (e.rect.x() < x2 && area.x() < e.x2 &&
+                        e.rect.y() < y2 && area.y() < e.y2 &&
+                        (c == c1 || e.rect.x() >= c * int(fSize)) &&
+                        (r == r1 || e.rect.y() >= r * int(fSize)))
+                    {
+                        visit(e.item);
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    // the area covered by the grid, keeps all items
+    void resize(unsigned width, unsigned height);
+    void clear();
+    int count() const { return fCount; }
+
+private:
+    struct Entry {
+        AnyPointer item;
+        YRect rect;
+        int x2, y2;
+    };
+    typedef YArray<Entry> Cell;
+
+    int column(int x) const {
+        return x < 0 ? 0 : min(int(unsigned(x) / fSize), fColumns - 1);
+    }
+    int row(int y) const {
+        return y < 0 ? 0 : min(int(unsigned(y) / fSize), fRows - 1);
+    }
+    Cell& cell(int col, int row) const {
+        return fCells[row * fColumns + col];
+    }
+
+    Cell* fCells;
+    int fColumns;
+    int fRows;
+    unsigned const fSize;
+    int fCount;
+
+    YAnyGrid(const YAnyGrid&);
+    YAnyGrid& operator=(const YAnyGrid&);
+};
+
+template <typename T>
+class YGrid : public YAnyGrid {
+public:
+    explicit YGrid(unsigned cellSize = 256) : YAnyGrid(cellSize) { }
+
+    void insert(T* item, const YRect& rect) {
+        YAnyGrid::insert(AnyPointer(item), rect);
+    }
+    bool remove(T* item, const YRect& rect) {
+        return YAnyGrid::remove(AnyPointer(item), rect);
+    }
+    // the item moved or was resized from old to rect
+    void update(T* item, const YRect& old, const YRect& rect) {
+        remove(item, old);
+        insert(item, rect);
+    }
+
+    // call visit(T*) for each item whose rectangle intersects area
+    template <class Visitor>
+    void visit(const YRect& area, Visitor visit) const {
+        auto any = [&visit] (AnyPointer item) { visit(static_cast<T*>(item)); };
+        visitAny(area, any);
+    }
+    // append to found the items whose rectangle intersects area
+    void query(const YRect& area, YArray<T*>& found) const {
+        visit(area, [&found] (T* item) { found.append(item); });
+    }
+};
+
+#endif
+
+// vim: set sw=4 ts=4 et:
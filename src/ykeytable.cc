@@ -0,0 +1,62 @@
+/*
+ * IceWM - map key bindings to actions
+ */
+#include "config.h"
+#include "ykeytable.h"
+#include <stdlib.h>
+
+YKeyTable::~YKeyTable() {
+    free(table);
+}
+
+void YKeyTable::resize(unsigned capacity) {
+    Slot* old = table;
+    unsigned size = old ? mask + 1 : 0;
+
+    table = static_cast<Slot *>(calloc(capacity, sizeof(Slot)));
+    if (table == nullptr) {
+        table = old;
+        return;
+    }
+    mask = capacity - 1;
+    for (unsigned k = 0; k < size; ++k) {
+        if (old[k].key) {
+            unsigned i = home(old[k].key, old[k].mod);
+            while (table[i].key)
+                i = (i + 1) & mask;
+            table[i] = old[k];
+        }
+    }
+    free(old);
+}
+
+bool YKeyTable::add(KeySym key, unsigned mod, int action) {
+    if (key == NoSymbol || action < 0)
+        return false;
+
+    // keep the load factor below 1/2
+    if (table == nullptr || 2 * (count + 1) > mask + 1)
+        resize(table ? 2 * (mask + 1) : 64);
+    if (table == nullptr)
+        return false;
+
+    unsigned i = home(key, mod);
+    for (; table[i].key; i = (i + 1) & mask) {
+        if (table[i].key == key && table[i].mod == mod)
+            return false;
+    }
+    table[i].key = key;
+    table[i].mod = mod;
+    table[i].action = action;
+    count += 1;
+    return true;
+}
+
+void YKeyTable::clear() {
+    free(table);
+    table = nullptr;
+    mask = 0;
+    count = 0;
+}
+
+// vim: set sw=4 ts=4 et:
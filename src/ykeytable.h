@@ -0,0 +1,57 @@
+#ifndef YKEYTABLE_H
+#define YKEYTABLE_H
+
+#include <X11/X.h>
+
+// Map key bindings, a keysym with virtual modifiers, to actions
+// in an open-addressing hash table with linear probing.
+// The first action bound to a key takes precedence.
+class YKeyTable {
+public:
+    YKeyTable() : table(nullptr), mask(0), count(0) { }
+    ~YKeyTable();
+
+    // bind a key to a non-negative action, unless already bound
+    bool add(KeySym key, unsigned mod, int action);
+
+    // the action bound to a key, or -1
+    int find(KeySym key, unsigned mod) const {
+        if (table && key) {
+            for (unsigned i = home(key, mod); table[i].key;
+                 i = (i + 1) & mask)
+            {
+                if (table[i].key == key && table[i].mod == mod)
+                    return table[i].action;
+            }
+        }
+        return -1;
+    }
+
+    void clear();
+    unsigned size() const { return count; }
+
+private:
+    struct Slot {
+        KeySym key;
+        unsigned mod;
+        int action;
+    };
+
+    Slot* table;
+    unsigned mask;
+    unsigned count;
+
+    unsigned home(KeySym key, unsigned mod) const {
+        unsigned long h = key ^ (key >> 16) ^ (mod * 0x9E3779B9UL);
+        return unsigned(h * 2654435761UL) & mask;
+    }
+
+    void resize(unsigned capacity);
+
+    YKeyTable(const YKeyTable&);
+    YKeyTable& operator=(const YKeyTable&);
+};
+
+#endif
+
+// vim: set sw=4 ts=4 et:
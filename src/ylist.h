@@ -190,6 +190,9 @@ class YFocusedNode : public YFrameNode {
 class YCreatedNode : public YFrameNode {
 };
 
+class YWorkspaceNode : public YFrameNode {
+};
+
 class YFrameIter;
 
 template <class Node>
@@ -214,6 +217,8 @@ class YFocusedList : public YFrameList<YFocusedNode> { };
 
 class YCreatedList : public YFrameList<YCreatedNode> { };
 
+class YWorkspaceList : public YFrameList<YWorkspaceNode> { };
+
 class YFrameIter : public YListIter<YFrameNode> {
     typedef YListIter<YFrameNode> ListIter;
 
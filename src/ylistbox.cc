@@ -594,10 +594,14 @@ void YListBox::paintItem(int i) {
     if (i >= 0 && i < getItemCount() && fVisible) {
         int y = i * getLineHeight() - fOffsetY;
         YRect r(0, y, width(), getLineHeight());
-        fGraphics.paint(r);
+        addDamage(r);
     }
 }
 
+void YListBox::paintRegion(Region region, const YRect& bounds) {
+    fGraphics.paint(region, bounds);
+}
+
 void YListBox::activateItem(YListItem *item) {
 }
 
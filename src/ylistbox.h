@@ -52,6 +52,7 @@ public:
     virtual void outdated();
     virtual void repaint();
     virtual void paint(Graphics &g, const YRect &r);
+    virtual void paintRegion(Region region, const YRect& bounds);
     virtual void scroll(YScrollBar *sb, int delta);
     virtual void move(YScrollBar *sb, int pos);
 
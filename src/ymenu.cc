@@ -912,7 +912,11 @@ void YMenu::repaintItem(int item) {
     unsigned h;
 
     if (findItemPos(item, x, y, h) != -1)
-        fGraphics.paint(YRect(0, y, width(), h));
+        addDamage(YRect(0, y, width(), h));
+}
+
+void YMenu::paintRegion(Region region, const YRect& bounds) {
+    fGraphics.paint(region, bounds);
 }
 
 void YMenu::paintItems() {
@@ -19,6 +19,7 @@ public:
     virtual void donePopup(YPopupWindow *popup);
 
     virtual void paint(Graphics &g, const YRect &r);
+    virtual void paintRegion(Region region, const YRect& bounds);
 
     virtual bool handleKey(const XKeyEvent &key);
     virtual void handleButton(const XButtonEvent &button);
@@ -9,7 +9,9 @@
 #include "yprefs.h"
 #include "ascii.h"
 #include "intl.h"
+#include "ytrace.h"
 #include <stdlib.h>
+#include <time.h>
 
 #ifdef CONFIG_XFREETYPE
 #include <X11/Xft/Xft.h>
@@ -19,17 +21,219 @@ static inline Display* display()  { return xapp->display(); }
 
 /******************************************************************************/
 
+// Graphics are short-lived: GraphicsBuffer makes one for every repaint.
+// Their GCs and XftDraws are kept here for the next Graphics of the same
+// depth, which saves a CreateGC and FreeGC per repaint. Returned GCs are
+// reset to the state of a new GC, except that graphics exposures are off.
+// A tile, stipple or font is reset by copying it from an unused GC.
+class GraphicsPool {
+public:
+    GraphicsPool() :
+        gcCreated(0), gcReused(0),
+        paintCount(0), paintRequests(0), paintMinute(0) { }
+
+    GC getGC(Drawable drawable, unsigned depth,
+             unsigned long vmask, XGCValues* gcv);
+    void putGC(GC gc, unsigned depth, unsigned long refs);
+#ifdef CONFIG_XFREETYPE
+    XftDraw* getDraw(Drawable drawable, unsigned depth);
+    void putDraw(XftDraw* draw, unsigned depth);
+#endif
+    void countPaint(unsigned long requests);
+    void clear();
+
+private:
+    template<class T>
+    struct Entry {
+        T handle;
+        unsigned depth;
+    };
+    // at most this many spare handles are kept per kind
+    enum { Limit = 16 };
+
+    template<class T>
+    static bool take(YArray<Entry<T>>& pool, unsigned depth, T& handle) {
+        for (int i = pool.getCount(); --i >= 0; ) {
+            if (pool[i].depth == depth) {
+                handle = pool[i].handle;
+                pool[i] = pool[pool.getCount() - 1];
+                pool.shrink(pool.getCount() - 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    GC defaultGC(unsigned depth) const {
+        for (const Entry<GC>& entry : fDefaults) {
+            if (entry.depth == depth)
+                return entry.handle;
+        }
+        return None;
+    }
+
+    YArray<Entry<GC>> fGCs;
+    YArray<Entry<GC>> fDefaults;    // one unmodified GC per depth
+#ifdef CONFIG_XFREETYPE
+    YArray<Entry<XftDraw*>> fDraws;
+#endif
+    unsigned long gcCreated, gcReused;
+    unsigned long paintCount, paintRequests;
+    time_t paintMinute;
+};
+
+static GraphicsPool graphicsPool;
+
+GC GraphicsPool::getGC(Drawable drawable, unsigned depth,
+                       unsigned long vmask, XGCValues* gcv)
+{
+    GC gc;
+    if (take(fGCs, depth, gc)) {
+        ++gcReused;
+        if (vmask) {
+            XChangeGC(display(), gc, vmask, gcv);
+        }
+    } else {
+        ++gcCreated;
+        if (defaultGC(depth) == None) {
+            Entry<GC> entry = {
+                XCreateGC(display(), drawable, None, nullptr), depth
+            };
+            fDefaults += entry;
+        }
+
+        XGCValues values;
+        values.graphics_exposures = False;
+        gc = XCreateGC(display(), drawable, GCGraphicsExposures, &values);
+        if (vmask) {
+            XChangeGC(display(), gc, vmask, gcv);
+        }
+    }
+    return gc;
+}
+
+void GraphicsPool::putGC(GC gc, unsigned depth, unsigned long refs) {
+    if (fGCs.getCount() < Limit) {
+        // release the pixmaps and font which the GC refers to
+        refs &= (GCTile | GCStipple | GCFont);
+        if (refs) {
+            XCopyGC(display(), defaultGC(depth), refs, gc);
+        }
+
+        // Xlib caches the GC values: only the modified ones are sent,
+        // and not before the GC is used again.
+        XGCValues gcv;
+        gcv.function = GXcopy;
+        gcv.plane_mask = AllPlanes;
+        gcv.foreground = 0;
+        gcv.background = 1;
+        gcv.line_width = 0;
+        gcv.line_style = LineSolid;
+        gcv.cap_style = CapButt;
+        gcv.join_style = JoinMiter;
+        gcv.fill_style = FillSolid;
+        gcv.fill_rule = EvenOddRule;
+        gcv.arc_mode = ArcPieSlice;
+        gcv.ts_x_origin = 0;
+        gcv.ts_y_origin = 0;
+        gcv.subwindow_mode = ClipByChildren;
+        gcv.graphics_exposures = False;
+        gcv.clip_x_origin = 0;
+        gcv.clip_y_origin = 0;
+        gcv.clip_mask = None;
+        gcv.dash_offset = 0;
+        gcv.dashes = 4;
+        XChangeGC(display(), gc,
+                  GCFunction | GCPlaneMask | GCForeground | GCBackground |
+                  GCLineWidth | GCLineStyle | GCCapStyle | GCJoinStyle |
+                  GCFillStyle | GCFillRule | GCArcMode |
+                  GCTileStipXOrigin | GCTileStipYOrigin |
+                  GCSubwindowMode | GCGraphicsExposures |
+                  GCClipXOrigin | GCClipYOrigin | GCClipMask |
+                  GCDashOffset | GCDashList, &gcv);
+        Entry<GC> entry = { gc, depth };
+        fGCs += entry;
+    } else {
+        XFreeGC(display(), gc);
+    }
+}
+
+#ifdef CONFIG_XFREETYPE
+XftDraw* GraphicsPool::getDraw(Drawable drawable, unsigned depth) {
+    XftDraw* draw;
+    if (take(fDraws, depth, draw)) {
+        XftDrawChange(draw, drawable);
+    } else {
+        draw = XftDrawCreate(display(), drawable,
+                             xapp->visualForDepth(depth),
+                             xapp->colormapForDepth(depth));
+    }
+    return draw;
+}
+
+void GraphicsPool::putDraw(XftDraw* draw, unsigned depth) {
+    if (fDraws.getCount() < Limit) {
+        // release the picture while its drawable still exists
+        XftDrawChange(draw, None);
+        XftDrawSetClip(draw, nullptr);
+        Entry<XftDraw*> entry = { draw, depth };
+        fDraws += entry;
+    } else {
+        XftDrawDestroy(draw);
+    }
+}
+#endif
+
+void GraphicsPool::countPaint(unsigned long requests) {
+    ++paintCount;
+    paintRequests += requests;
+    time_t now = time(nullptr);
+    if (paintMinute + 60 <= now) {
+        if (paintMinute) {
+            tlog("%lu repaints with %lu requests, %lu of %lu GCs reused",
+                 paintCount, paintRequests,
+                 gcReused, gcReused + gcCreated);
+        }
+        paintMinute = now;
+        paintCount = 0;
+        paintRequests = 0;
+    }
+}
+
+void GraphicsPool::clear() {
+    for (const Entry<GC>& entry : fGCs) {
+        XFreeGC(display(), entry.handle);
+    }
+    fGCs.clear();
+    for (const Entry<GC>& entry : fDefaults) {
+        XFreeGC(display(), entry.handle);
+    }
+    fDefaults.clear();
+#ifdef CONFIG_XFREETYPE
+    for (const Entry<XftDraw*>& entry : fDraws) {
+        XftDrawDestroy(entry.handle);
+    }
+    fDraws.clear();
+#endif
+}
+
+void Graphics::freePool() {
+    graphicsPool.clear();
+}
+
 Graphics::Graphics(YWindow & window,
                    unsigned long vmask, XGCValues * gcv):
     fDrawable(window.handle()),
     fColor(), fFont(null),
     fPicture(None),
+    fGCRefs(None),
     xOrigin(0), yOrigin(0)
 {
     rWidth = window.width();
     rHeight = window.height();
     rDepth = (window.depth() ? window.depth() : xapp->depth());
-    gc = XCreateGC(display(), drawable(), vmask, gcv);
+    gc = graphicsPool.getGC(drawable(), rDepth, vmask, gcv);
+    fGCRefs = vmask;
 #ifdef CONFIG_XFREETYPE
     fXftDraw = nullptr;
 #endif
@@ -39,13 +243,13 @@ Graphics::Graphics(YWindow & window):
     fDrawable(window.handle()),
     fColor(), fFont(null),
     fPicture(None),
+    fGCRefs(None),
     xOrigin(0), yOrigin(0)
  {
     rWidth = window.width();
     rHeight = window.height();
     rDepth = (window.depth() ? window.depth() : xapp->depth());
-    XGCValues gcv; gcv.graphics_exposures = False;
-    gc = XCreateGC(display(), drawable(), GCGraphicsExposures, &gcv);
+    gc = graphicsPool.getGC(drawable(), rDepth, None, nullptr);
 #ifdef CONFIG_XFREETYPE
     fXftDraw = nullptr;
 #endif
@@ -55,13 +259,13 @@ Graphics::Graphics(ref<YPixmap> pixmap, int x_org, int y_org):
     fDrawable(pixmap->pixmap()),
     fColor(), fFont(null),
     fPicture(None),
+    fGCRefs(None),
     xOrigin(x_org), yOrigin(y_org)
  {
     rWidth = pixmap->width();
     rHeight = pixmap->height();
     rDepth = pixmap->depth();
-    XGCValues gcv; gcv.graphics_exposures = False;
-    gc = XCreateGC(display(), drawable(), GCGraphicsExposures, &gcv);
+    gc = graphicsPool.getGC(drawable(), rDepth, None, nullptr);
 #ifdef CONFIG_XFREETYPE
     fXftDraw = nullptr;
 #endif
@@ -72,10 +276,12 @@ Graphics::Graphics(Drawable drawable, unsigned w, unsigned h, unsigned depth,
     fDrawable(drawable),
     fColor(), fFont(null),
     fPicture(None),
+    fGCRefs(None),
     xOrigin(0), yOrigin(0),
     rWidth(w), rHeight(h), rDepth(depth)
 {
-    gc = XCreateGC(display(), drawable, vmask, gcv);
+    gc = graphicsPool.getGC(drawable, depth, vmask, gcv);
+    fGCRefs = vmask;
 #ifdef CONFIG_XFREETYPE
     fXftDraw = nullptr;
 #endif
@@ -85,18 +291,18 @@ Graphics::Graphics(Drawable drawable, unsigned w, unsigned h, unsigned depth):
     fDrawable(drawable),
     fColor(), fFont(null),
     fPicture(None),
+    fGCRefs(None),
     xOrigin(0), yOrigin(0),
     rWidth(w), rHeight(h), rDepth(depth)
 {
-    XGCValues gcv; gcv.graphics_exposures = False;
-    gc = XCreateGC(display(), drawable, GCGraphicsExposures, &gcv);
+    gc = graphicsPool.getGC(drawable, depth, None, nullptr);
 #ifdef CONFIG_XFREETYPE
     fXftDraw = nullptr;
 #endif
 }
 
 Graphics::~Graphics() {
-    XFreeGC(display(), gc);
+    graphicsPool.putGC(gc, rDepth, fGCRefs);
     gc = None;
 
     if (fPicture) {
@@ -106,7 +312,7 @@ Graphics::~Graphics() {
 
 #ifdef CONFIG_XFREETYPE
     if (fXftDraw) {
-        XftDrawDestroy(fXftDraw);
+        graphicsPool.putDraw(fXftDraw, rDepth);
         fXftDraw = nullptr;
     }
 #endif
@@ -115,9 +321,7 @@ Graphics::~Graphics() {
 #ifdef CONFIG_XFREETYPE
 XftDraw* Graphics::handleXft() {
     if (fXftDraw == nullptr) {
-        fXftDraw = XftDrawCreate(display(), drawable(),
-                                 xapp->visualForDepth(rdepth()),
-                                 xapp->colormapForDepth(rdepth()));
+        fXftDraw = graphicsPool.getDraw(drawable(), rdepth());
     }
     return fXftDraw;
 }
@@ -811,6 +1015,7 @@ void Graphics::repHorz(Drawable d, unsigned pw, unsigned ph, int x, int y, unsig
         return;
 #if 1
     XSetTile(display(), gc, d);
+    fGCRefs |= GCTile;
     XSetTSOrigin(display(), gc, x - xOrigin, y - yOrigin);
     XSetFillStyle(display(), gc, FillTiled);
     XFillRectangle(display(), drawable(), gc, x - xOrigin, y - yOrigin, w, ph);
@@ -829,6 +1034,7 @@ void Graphics::repVert(Drawable d, unsigned pw, unsigned ph, int x, int y, unsig
         return;
 #if 1
     XSetTile(display(), gc, d);
+    fGCRefs |= GCTile;
     XSetTSOrigin(display(), gc, x - xOrigin, y - yOrigin);
     XSetFillStyle(display(), gc, FillTiled);
     XFillRectangle(display(), drawable(), gc, x - xOrigin, y - yOrigin, pw, h);
@@ -1048,6 +1254,17 @@ void Graphics::setClipRectangles(XRectangle *rect, int count) {
 #endif
 }
 
+void Graphics::setClipRegion(Region region) {
+    Region clip = XCreateRegion();
+    XUnionRegion(region, clip, clip);
+    XOffsetRegion(clip, -xOrigin, -yOrigin);
+    XSetRegion(display(), gc, clip);
+#ifdef CONFIG_XFREETYPE
+    XftDrawSetClip(handleXft(), clip);
+#endif
+    XDestroyRegion(clip);
+}
+
 void Graphics::setClipMask(Pixmap mask) {
     XSetClipMask(display(), gc, mask);
 }
@@ -1070,7 +1287,7 @@ void Graphics::maxOpacity() {
 
 /******************************************************************************/
 
-void GraphicsBuffer::paint(Pixmap pixmap, const YRect& rect) {
+void GraphicsBuffer::paint(Pixmap pixmap, const YRect& rect, Region region) {
     if (window()->handle() && window()->destroyed())
         return;
 
@@ -1087,33 +1304,45 @@ void GraphicsBuffer::paint(Pixmap pixmap, const YRect& rect) {
 
     fNesting += 1;
 
-    Graphics gfx(pixmap, w, h, depth);
+    static const bool tracing = YTrace::traces("paint");
+    const unsigned long request = NextRequest(display());
+    {
+        Graphics gfx(pixmap, w, h, depth);
 
-    if (fNesting == 1) {
-        if (fClipping || x || y ||
-            w < window()->width() || h < window()->height())
-        {
-            XRectangle clip = { short(x), short(y),
-                               (unsigned short)w, (unsigned short)h };
-            gfx.setClipRectangles(&clip, 1);
-            clipping = true;
-        }
+        if (fNesting == 1) {
+            if (region) {
+                gfx.setClipRegion(region);
+                clipping = true;
+            }
+            else if (fClipping || x || y ||
+                w < window()->width() || h < window()->height())
+            {
+                XRectangle clip = { short(x), short(y),
+                                   (unsigned short)w, (unsigned short)h };
+                gfx.setClipRectangles(&clip, 1);
+                clipping = true;
+            }
 
-        gfx.clearArea(x, y, w, h);
-    }
+            gfx.clearArea(x, y, w, h);
+        }
 
-    window()->paint(gfx, rect);
+        window()->paint(gfx, rect);
 
-    if (fNesting == 1) {
-        if (pixmap == fPixmap && !window()->destroyed()) {
-            window()->setBackgroundPixmap(pixmap);
-            window()->clearArea(x, y, w, h);
-        }
-        if (clipping) {
-            gfx.resetClip();
+        if (fNesting == 1) {
+            if (pixmap == fPixmap && !window()->destroyed()) {
+                window()->setBackgroundPixmap(pixmap);
+                window()->clearArea(x, y, w, h);
+            }
+            if (clipping) {
+                gfx.resetClip();
+            }
         }
     }
 
+    if (fNesting == 1 && tracing) {
+        graphicsPool.countPaint(NextRequest(display()) - request);
+    }
+
     fNesting -= 1;
 }
 
@@ -1134,6 +1363,16 @@ void GraphicsBuffer::paint(const YRect& rect) {
     }
 }
 
+void GraphicsBuffer::paint(Region region, const YRect& bounds) {
+    // a new pixmap has no valid content outside of the region
+    if (fPixmap == None || fDim != window()->dimension()) {
+        paint();
+    }
+    else {
+        GraphicsBuffer::paint(fPixmap, bounds, region);
+    }
+}
+
 void GraphicsBuffer::paint() {
     YRect rect(0, 0, window()->width(), window()->height());
     paint(rect);
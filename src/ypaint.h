@@ -14,6 +14,7 @@
 #endif
 
 #include "ycolor.h"
+#include <X11/Xutil.h>
 
 class YWindow;
 
@@ -176,6 +177,8 @@ public:
 
     Drawable drawable() const { return fDrawable; }
     GC handleX() const { return gc; }
+    // note that a font or pixmap was set in the GC of handleX()
+    void referGC(unsigned long mask) { fGCRefs |= mask; }
 #ifdef CONFIG_XFREETYPE
     struct _XftDraw* handleXft();
 #endif
@@ -191,10 +194,14 @@ public:
     Picture picture();
 
     void setClipRectangles(XRectangle *rect, int count);
+    void setClipRegion(Region region);
     void setClipMask(Pixmap mask = None);
     void resetClip();
     void maxOpacity();
 
+    // free the spare GCs and XftDraws before closing the display
+    static void freePool();
+
 private:
     Drawable fDrawable;
     GC gc;
@@ -205,6 +212,7 @@ private:
     YColor   fColor;
     ref<YFont> fFont;
     Picture fPicture;
+    unsigned long fGCRefs;
     int xOrigin, yOrigin;
     unsigned rWidth, rHeight, rDepth;
 };
@@ -224,6 +232,7 @@ public:
     }
     ~GraphicsBuffer();
     void paint(const class YRect& rect);
+    void paint(Region region, const class YRect& bounds);
     void paint();
     void release();
 
@@ -239,7 +248,7 @@ private:
     YDimension fDim;
 
     Pixmap pixmap();
-    void paint(Pixmap p, const class YRect& rect);
+    void paint(Pixmap p, const class YRect& rect, Region region = nullptr);
 };
 
 #endif
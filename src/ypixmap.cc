@@ -31,9 +31,9 @@ void YPixmap::replicate(bool horiz, bool copyMask) {
 
     if (nMask != None) {
         if (horiz)
-            Graphics(nMask, dim, height(), depth()).repHorz(fMask, width(), height(), 0, 0, dim);
+            Graphics(nMask, dim, height(), 1).repHorz(fMask, width(), height(), 0, 0, dim);
         else
-            Graphics(nMask, width(), dim, depth()).repVert(fMask, width(), height(), 0, 0, dim);
+            Graphics(nMask, width(), dim, 1).repVert(fMask, width(), height(), 0, 0, dim);
     }
 
     if (fPixmap != None)
@@ -1,9 +1,11 @@
 #ifndef __YPOLL_H__
 #define __YPOLL_H__
 
+// Call registerPoll again after a change to forRead or forWrite,
+// so that the main loop can update its interest in this descriptor.
 class YPollBase {
 public:
-    YPollBase(): fFd(-1), fRegistered(false) { }
+    YPollBase(): fFd(-1), fRegistered(false), fEvents(0) { }
     virtual ~YPollBase();
 
     virtual void notifyRead() { }
@@ -24,6 +26,9 @@ protected:
 private:
     int fFd;
     bool fRegistered;
+    unsigned fEvents;   // epoll events currently requested
+
+    friend class YApplication;
 };
 
 template<class T>
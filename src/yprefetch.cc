@@ -0,0 +1,386 @@
+/*
+ * IceWM - prefetch the properties of a window to adopt
+ */
+#include "config.h"
+#include "yprefetch.h"
+#include "wmmgr.h"
+#include "MwmUtil.h"
+#include "base.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xatom.h>
+#ifdef CONFIG_XCB
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+#endif
+
+YPrefetch* YPrefetch::fPrefetch;
+
+YPrefetch::YPrefetch() :
+    fCount(0),
+    fLast(nullptr),
+    fOuterPrefetch(fPrefetch)
+{
+    // the same limits as the YFrameClient getters use
+    const struct {
+        Atom prop;
+        long limit;
+    } props[] = {
+        { XA_WM_NAME,                   BUFSIZ },
+        { XA_WM_ICON_NAME,              BUFSIZ },
+        { XA_WM_CLASS,                  BUFSIZ },
+        { XA_WM_HINTS,                  9L },
+        { XA_WM_NORMAL_HINTS,           18L },
+        { XA_WM_TRANSIENT_FOR,          1L },
+        { _XA_WM_PROTOCOLS,             32L },
+        { _XA_WM_CLIENT_LEADER,         1L },
+        { _XA_WM_WINDOW_ROLE,           256L },
+        { _XA_WINDOW_ROLE,              256L },
+        { _XA_WM_STATE,                 2L },
+        { _XATOM_MWM_HINTS,             PROP_MWM_HINTS_ELEMENTS },
+        { _XA_NET_WM_NAME,              BUFSIZ },
+        { _XA_NET_WM_ICON_NAME,         BUFSIZ },
+        { _XA_NET_WM_WINDOW_TYPE,       16L },
+        { _XA_NET_WM_STATE,             32L },
+        { _XA_NET_WM_DESKTOP,           1L },
+        { _XA_NET_WM_STRUT,             4L },
+        { _XA_NET_WM_STRUT_PARTIAL,     12L },
+        { _XA_NET_STARTUP_ID,           BUFSIZ },
+        { _XA_NET_WM_USER_TIME,         1L },
+        { _XA_NET_WM_USER_TIME_WINDOW,  1L },
+        { _XA_NET_WM_WINDOW_OPACITY,    1L },
+        { _XA_NET_WM_PID,               1L },
+        { _XA_NET_WM_ICON,              1L << 22 },
+        { _XA_WIN_WORKSPACE,            1L },
+        { _XA_WIN_LAYER,                1L },
+        { _XA_WIN_TRAY,                 1L },
+        { _XA_WIN_STATE,                2L },
+        { _XA_WIN_HINTS,                1L },
+        { _XA_WIN_ICONS,                4096L },
+        { _XA_KWM_WIN_ICON,             2L },
+    };
+    static_assert(ACOUNT(props) <= Capacity, "YPrefetch::Capacity");
+
+    for (int i = 0; i < int ACOUNT(props); ++i) {
+        fProps[i] = props[i].prop;
+        fLimits[i] = props[i].limit;
+    }
+    fCount = int ACOUNT(props);
+    fPrefetch = this;
+}
+
+YPrefetch::~YPrefetch() {
+    while (fBatches.getCount())
+        release(fBatches[fBatches.getCount() - 1]);
+    fPrefetch = fOuterPrefetch;
+}
+
+YPrefetch::Batch* YPrefetch::find(Window window) {
+    if (fLast && fLast->window == window)
+        return fLast;
+    for (int i = 0; i < fBatches.getCount(); ++i) {
+        if (fBatches[i]->window == window)
+            return fLast = fBatches[i];
+    }
+    return nullptr;
+}
+
+void YPrefetch::release(Window window) {
+    Batch* batch = find(window);
+    if (batch)
+        release(batch);
+}
+
+void YPrefetch::release(Batch* batch) {
+    release(batch->attributes);
+    release(batch->geometry);
+    release(batch->list);
+    for (int i = 0; i < fCount; ++i)
+        release(batch->props[i]);
+    if (fLast == batch)
+        fLast = nullptr;
+    findRemove(fBatches, batch);
+}
+
+void YPrefetch::forgetProperty(Window window, Atom prop) {
+    Batch* batch = find(window);
+    for (int i = 0; batch && i < fCount; ++i) {
+        if (fProps[i] == prop) {
+            release(batch->props[i]);
+            break;
+        }
+    }
+}
+
+bool YPrefetch::attributes(Window window, XWindowAttributes* attributes) {
+    for (YPrefetch* p = fPrefetch; p; p = p->fOuterPrefetch) {
+        if (p->cachedAttributes(window, attributes))
+            return true;
+    }
+    return XGetWindowAttributes(xapp->display(), window, attributes);
+}
+
+#ifdef CONFIG_XCB
+
+void YPrefetch::request(Window window) {
+    for (YPrefetch* p = this; p; p = p->fOuterPrefetch) {
+        if (p->find(window))
+            return;
+    }
+    xcb_connection_t* conn = XGetXCBConnection(xapp->display());
+    if (conn == nullptr || window == None)
+        return;
+
+    Batch* batch = new Batch;
+    batch->window = window;
+    batch->collected = false;
+    batch->attributes.sequence =
+        xcb_get_window_attributes(conn, window).sequence;
+    batch->geometry.sequence = xcb_get_geometry(conn, window).sequence;
+    batch->list.sequence = xcb_list_properties(conn, window).sequence;
+    for (int i = 0; i < fCount; ++i) {
+        batch->props[i].sequence =
+            xcb_get_property(conn, False, window, fProps[i],
+                             XCB_GET_PROPERTY_TYPE_ANY, 0, fLimits[i]).sequence;
+    }
+    batch->attributes.pending = batch->geometry.pending = true;
+    batch->attributes.reply = batch->geometry.reply = nullptr;
+    batch->list.pending = true;
+    batch->list.reply = nullptr;
+    for (int i = 0; i < fCount; ++i) {
+        batch->props[i].pending = true;
+        batch->props[i].reply = nullptr;
+    }
+    fBatches.append(batch);
+    xcb_flush(conn);
+}
+
+void YPrefetch::collect(Batch* batch) {
+    if (batch->collected)
+        return;
+
+    xcb_connection_t* conn = XGetXCBConnection(xapp->display());
+    xcb_generic_error_t* error = nullptr;
+    if (batch->attributes.pending) {
+        xcb_get_window_attributes_cookie_t cookie = {
+            batch->attributes.sequence };
+        batch->attributes.reply =
+            xcb_get_window_attributes_reply(conn, cookie, &error);
+        batch->attributes.pending = false;
+        free(error);
+    }
+    if (batch->geometry.pending) {
+        xcb_get_geometry_cookie_t cookie = { batch->geometry.sequence };
+        batch->geometry.reply = xcb_get_geometry_reply(conn, cookie, &error);
+        batch->geometry.pending = false;
+        free(error);
+    }
+    if (batch->list.pending) {
+        xcb_list_properties_cookie_t cookie = { batch->list.sequence };
+        batch->list.reply = xcb_list_properties_reply(conn, cookie, &error);
+        batch->list.pending = false;
+        free(error);
+    }
+    for (int i = 0; i < fCount; ++i) {
+        if (batch->props[i].pending) {
+            xcb_get_property_cookie_t cookie = { batch->props[i].sequence };
+            batch->props[i].reply =
+                xcb_get_property_reply(conn, cookie, &error);
+            batch->props[i].pending = false;
+            free(error);
+        }
+    }
+    batch->collected = true;
+}
+
+void YPrefetch::release(Reply& reply) {
+    if (reply.pending) {
+        xcb_discard_reply(XGetXCBConnection(xapp->display()), reply.sequence);
+        reply.pending = false;
+    }
+    free(reply.reply);
+    reply.reply = nullptr;
+}
+
+// emulate XGetWindowProperty on a reply which was requested
+// for AnyPropertyType: format 32 items become longs, all data
+// is followed by a null byte and allocated by malloc for XFree.
+bool YPrefetch::cachedProperty(Window window, Atom prop, long limit,
+                               Atom kind, Atom* type, int* format,
+                               unsigned long* count, unsigned long* after,
+                               unsigned char** data)
+{
+    Batch* batch = find(window);
+    if (batch == nullptr)
+        return false;
+
+    int k = 0;
+    while (k < fCount && fProps[k] != prop)
+        ++k;
+    if (k == fCount)
+        return false;
+
+    collect(batch);
+    xcb_get_property_reply_t* r =
+        static_cast<xcb_get_property_reply_t *>(batch->props[k].reply);
+    if (r == nullptr || (limit > fLimits[k] && r->bytes_after))
+        return false;
+
+    *type = r->type;
+    *format = r->format;
+    *count = 0;
+    *after = 0;
+    *data = nullptr;
+    if (r->type == None)
+        return true;
+
+    unsigned width = max(1U, r->format / 8U);
+    unsigned long total = r->value_len;
+    unsigned long items = (kind && kind != r->type) ? 0UL :
+        min(total, (unsigned long) limit * 4UL / width);
+    *after = r->bytes_after + (total - items) * width;
+    *count = items;
+
+    const void* value = xcb_get_property_value(r);
+    if (r->format == 32) {
+        long* copy = static_cast<long *>(malloc(items * sizeof(long) + 1));
+        const uint32_t* source = static_cast<const uint32_t *>(value);
+        for (unsigned long i = 0; copy && i < items; ++i)
+            copy[i] = long(int32_t(source[i]));
+        *data = reinterpret_cast<unsigned char *>(copy);
+    }
+    else if (r->format == 16) {
+        short* copy = static_cast<short *>(malloc(items * sizeof(short) + 1));
+        if (copy)
+            memcpy(copy, value, items * sizeof(short));
+        *data = reinterpret_cast<unsigned char *>(copy);
+    }
+    else {
+        unsigned char* copy = static_cast<unsigned char *>(malloc(items + 1));
+        if (copy) {
+            memcpy(copy, value, items);
+            copy[items] = '\0';
+        }
+        *data = copy;
+    }
+    if (*data == nullptr)
+        *count = 0;
+    return true;
+}
+
+bool YPrefetch::cachedProperties(Window window, Atom** atoms, int* count) {
+    Batch* batch = find(window);
+    if (batch == nullptr)
+        return false;
+
+    collect(batch);
+    xcb_list_properties_reply_t* r =
+        static_cast<xcb_list_properties_reply_t *>(batch->list.reply);
+    if (r == nullptr)
+        return false;
+
+    *count = xcb_list_properties_atoms_length(r);
+    *atoms = nullptr;
+    if (*count > 0) {
+        *atoms = static_cast<Atom *>(malloc(*count * sizeof(Atom)));
+        if (*atoms == nullptr)
+            return false;
+        const xcb_atom_t* source = xcb_list_properties_atoms(r);
+        for (int i = 0; i < *count; ++i)
+            (*atoms)[i] = source[i];
+    }
+    return true;
+}
+
+// the Xlib visual of a visual id, as _XVIDtoVisual finds it
+static Visual* findVisual(Display* display, VisualID id) {
+    for (int i = 0; i < ScreenCount(display); ++i) {
+        Screen* screen = ScreenOfDisplay(display, i);
+        for (int j = 0; j < screen->ndepths; ++j) {
+            Depth* depth = &screen->depths[j];
+            for (int k = 0; k < depth->nvisuals; ++k) {
+                if (depth->visuals[k].visualid == id)
+                    return &depth->visuals[k];
+            }
+        }
+    }
+    return nullptr;
+}
+
+// emulate XGetWindowAttributes from the attributes and geometry replies
+bool YPrefetch::cachedAttributes(Window window, XWindowAttributes* attr) {
+    Batch* batch = find(window);
+    if (batch == nullptr)
+        return false;
+
+    collect(batch);
+    xcb_get_window_attributes_reply_t* a =
+        static_cast<xcb_get_window_attributes_reply_t *>(
+            batch->attributes.reply);
+    xcb_get_geometry_reply_t* g =
+        static_cast<xcb_get_geometry_reply_t *>(batch->geometry.reply);
+    if (a == nullptr || g == nullptr)
+        return false;
+
+    Display* display = xapp->display();
+    attr->x = g->x;
+    attr->y = g->y;
+    attr->width = g->width;
+    attr->height = g->height;
+    attr->border_width = g->border_width;
+    attr->depth = g->depth;
+    attr->visual = findVisual(display, a->visual);
+    attr->root = g->root;
+    attr->c_class = a->_class;
+    attr->bit_gravity = a->bit_gravity;
+    attr->win_gravity = a->win_gravity;
+    attr->backing_store = a->backing_store;
+    attr->backing_planes = a->backing_planes;
+    attr->backing_pixel = a->backing_pixel;
+    attr->save_under = a->save_under;
+    attr->colormap = a->colormap;
+    attr->map_installed = a->map_is_installed;
+    attr->map_state = a->map_state;
+    attr->all_event_masks = a->all_event_masks;
+    attr->your_event_mask = a->your_event_mask;
+    attr->do_not_propagate_mask = a->do_not_propagate_mask;
+    attr->override_redirect = a->override_redirect;
+    attr->screen = nullptr;
+    for (int i = 0; i < ScreenCount(display); ++i) {
+        if (RootWindow(display, i) == g->root)
+            attr->screen = ScreenOfDisplay(display, i);
+    }
+    return true;
+}
+
+#else
+
+void YPrefetch::request(Window window) {
+}
+
+void YPrefetch::collect(Batch* batch) {
+}
+
+void YPrefetch::release(Reply& reply) {
+}
+
+bool YPrefetch::cachedProperty(Window window, Atom prop, long limit,
+                               Atom kind, Atom* type, int* format,
+                               unsigned long* count, unsigned long* after,
+                               unsigned char** data)
+{
+    return false;
+}
+
+bool YPrefetch::cachedProperties(Window window, Atom** atoms, int* count) {
+    return false;
+}
+
+bool YPrefetch::cachedAttributes(Window window, XWindowAttributes* attr) {
+    return false;
+}
+
+#endif
+
+// vim: set sw=4 ts=4 et:
@@ -0,0 +1,74 @@
+#ifndef YPREFETCH_H
+#define YPREFETCH_H
+
+#include "yxapp.h"
+#include "yarray.h"
+
+// Sends the requests for the attributes and all properties which
+// YFrameClient reads when it adopts a window at once, and collects the
+// replies together on first use. The server grab in manageClient then
+// costs one round trip instead of one per property. Requests for many
+// windows can be pipelined. Without XCB everything is read synchronously
+// as before.
+class YPrefetch : public YPropertyCache {
+public:
+    YPrefetch();
+    virtual ~YPrefetch();
+
+    // request the attributes and properties of this window
+    void request(Window window);
+    // discard what remains for this window
+    void release(Window window);
+    // number of windows with requests
+    int pending() const { return fBatches.getCount(); }
+
+    // like XGetWindowAttributes, but served from a prefetch if possible
+    static bool attributes(Window window, XWindowAttributes* attributes);
+
+protected:
+    virtual bool cachedProperty(Window window, Atom prop, long limit,
+                                Atom kind, Atom* type, int* format,
+                                unsigned long* count, unsigned long* after,
+                                unsigned char** data);
+    virtual bool cachedProperties(Window window, Atom** atoms, int* count);
+    virtual void forgetProperty(Window window, Atom prop);
+
+private:
+    enum { Capacity = 40 };
+
+    struct Reply {
+        unsigned sequence;
+        void* reply;
+        bool pending;
+    };
+    struct Batch {
+        Window window;
+        bool collected;
+        Reply attributes;
+        Reply geometry;
+        Reply list;
+        Reply props[Capacity];
+    };
+
+    Batch* find(Window window);
+    void collect(Batch* batch);
+    void release(Reply& reply);
+    void release(Batch* batch);
+    bool cachedAttributes(Window window, XWindowAttributes* attributes);
+
+    int fCount;
+    Atom fProps[Capacity];
+    long fLimits[Capacity];
+    YObjectArray<Batch> fBatches;
+    Batch* fLast;
+    YPrefetch* fOuterPrefetch;
+
+    static YPrefetch* fPrefetch;
+
+    YPrefetch(const YPrefetch&);
+    YPrefetch& operator=(const YPrefetch&);
+};
+
+#endif
+
+// vim: set sw=4 ts=4 et:
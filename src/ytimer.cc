@@ -9,8 +9,10 @@
 #include "yprefs.h"
 
 YTimer::YTimer(long ms) :
-    fListener(nullptr), fInterval(0), fRunning(false), fFixed(false)
+    fListener(nullptr), fInterval(0),
+    fRunning(false), fFixed(false), fSampling(false)
 {
+    fIndex[0] = fIndex[1] = -1;
     if (ms > 0L) {
         setInterval(ms);
     }
@@ -20,8 +22,10 @@ YTimer::YTimer(long ms, YTimerListener* listener, bool start, bool fixed) :
     fListener(listener),
     fInterval(max(0L, ms)),
     fRunning(false),
-    fFixed(fixed)
+    fFixed(fixed),
+    fSampling(false)
 {
+    fIndex[0] = fIndex[1] = -1;
     if (start)
         startTimer();
 }
@@ -35,6 +39,13 @@ void YTimer::setFixed() {
     fFixed = true;
 }
 
+void YTimer::setSampling() {
+    // A periodic timer for an applet which samples the system state.
+    // It expires on a multiple of its interval on the wall clock,
+    // so that all applets and the clock wake up at the same time.
+    fSampling = true;
+}
+
 bool YTimer::isFixed() const {
     return fFixed || timeout_min == timeout_max;
 }
@@ -49,13 +60,32 @@ void YTimer::startTimer(long ms) {
 }
 
 void YTimer::startTimer() {
-    timeout = monotime() + millitime(fInterval);
+    timeout = fSampling && 0 < fInterval ? nextSample()
+            : monotime() + millitime(fInterval);
     fuzzTimer();
     enlist(true);
 }
 
+timeval YTimer::nextSample() const {
+    // Skip a sample which is due within the slack,
+    // because then this timer has just expired early.
+    const long long million = 1000000LL;
+    const long long grid = fInterval * 1000LL;
+    const timeval now = monotime();
+    const timeval wall = walltime();
+    const long long usec = wall.tv_sec * million + wall.tv_usec + grid / 4;
+    const long long next = (usec / grid + 1) * grid;
+    return now + maketime(next / million - wall.tv_sec,
+                          next % million - wall.tv_usec);
+}
+
 void YTimer::fuzzTimer() {
-    if (false == fFixed && inrange(DelayFuzziness, 1, 100)) {
+    if (fSampling && 0 < fInterval) {
+        // may expire early together with another timer, but not late
+        timeout_min = timeout - millitime(fInterval / 4);
+        timeout_max = timeout;
+    }
+    else if (false == fFixed && inrange(DelayFuzziness, 1, 100)) {
         // non-fixed timer: configure fuzzy timeout range
         // to allow for merging of several timers
         timeval fuzz = millitime((fInterval * DelayFuzziness) / 100L);
@@ -78,13 +108,14 @@ void YTimer::stopTimer() {
 }
 
 void YTimer::enlist(bool enable) {
-    if (fRunning != enable) {
-        fRunning = enable;
-        if (enable) {
-            mainLoop->registerTimer(this);
-        } else {
-            mainLoop->unregisterTimer(this);
-        }
+    if (enable) {
+        // a running timer has a new timeout and must be requeued
+        fRunning = true;
+        mainLoop->registerTimer(this);
+    }
+    else if (fRunning) {
+        fRunning = false;
+        mainLoop->unregisterTimer(this);
     }
 }
 
@@ -107,4 +138,61 @@ void YTimer::setTimer(long interval, YTimerListener *listener, bool start) {
         startTimer();
 }
 
+void YTimerQueue::insert(YTimer *t) {
+    for (int k = Min; k <= Max; ++k) {
+        fHeap[k].append(t);
+        t->fIndex[k] = fHeap[k].getCount() - 1;
+        siftUp(k, t->fIndex[k]);
+    }
+}
+
+void YTimerQueue::remove(YTimer *t) {
+    for (int k = Min; k <= Max; ++k) {
+        int i = t->fIndex[k];
+        int last = fHeap[k].getCount() - 1;
+        PRECONDITION(inrange(i, 0, last) && fHeap[k][i] == t);
+        if (i < last) {
+            place(k, i, fHeap[k][last]);
+            fHeap[k].shrink(last);
+            siftUp(k, i);
+            siftDown(k, fHeap[k][i]->fIndex[k]);
+        } else {
+            fHeap[k].shrink(last);
+        }
+        t->fIndex[k] = -1;
+    }
+}
+
+void YTimerQueue::update(YTimer *t) {
+    for (int k = Min; k <= Max; ++k) {
+        siftUp(k, t->fIndex[k]);
+        siftDown(k, t->fIndex[k]);
+    }
+}
+
+void YTimerQueue::siftUp(int k, int i) {
+    YTimer* t = fHeap[k][i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (before(k, t, fHeap[k][parent]) == false)
+            break;
+        place(k, i, fHeap[k][parent]);
+        i = parent;
+    }
+    place(k, i, t);
+}
+
+void YTimerQueue::siftDown(int k, int i) {
+    YTimer* t = fHeap[k][i];
+    const int count = fHeap[k].getCount();
+    for (int child; (child = 2 * i + 1) < count; i = child) {
+        if (child + 1 < count && before(k, fHeap[k][child + 1], fHeap[k][child]))
+            ++child;
+        if (before(k, fHeap[k][child], t) == false)
+            break;
+        place(k, i, fHeap[k][child]);
+    }
+    place(k, i, t);
+}
+
 // vim: set sw=4 ts=4 et:
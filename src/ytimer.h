@@ -27,6 +27,7 @@ public:
     long getInterval() const { return fInterval; }
 
     void setFixed();
+    void setSampling();
 
     void startTimer();
     void startTimer(long ms);
@@ -38,15 +39,19 @@ public:
 private:
     void enlist(bool enable);
     void fuzzTimer();
+    timeval nextSample() const;
 
     YTimerListener *fListener;
     long fInterval;
     bool fRunning;
     bool fFixed;
+    bool fSampling;
 
     struct timeval timeout_min, timeout, timeout_max;
+    int fIndex[2];
 
     friend class YApplication;
+    friend class YTimerQueue;
 };
 
 #endif
@@ -78,4 +78,35 @@ public:
     ~YTraceProg() { }
 };
 
+// A timed phase of startup.  When ICEWM_TRACE_STARTUP names a file,
+// each phase is appended to it as an event in the Chrome trace format,
+// with the resident memory at the end of the phase.
+class YTracePhase : public YTrace {
+public:
+    YTracePhase(const char* inst) :
+        YTrace("phase", inst), start(recording() ? micros() : 0LL) { }
+    ~YTracePhase() { done(); }
+
+    void done() {
+        if (start) {
+            record(getInst(), start, micros());
+            start = 0;
+        }
+        YTrace::done();
+    }
+
+    void init(const char* inst) {
+        done();
+        YTrace::init(inst);
+        start = recording() ? micros() : 0LL;
+    }
+
+private:
+    long long start;
+
+    static bool recording();
+    static long long micros();
+    static void record(const char* name, long long start, long long stop);
+};
+
 #endif
@@ -129,6 +129,7 @@ YWindow::YWindow(YWindow *parent, Window win, int depth,
     fX(0), fY(0), fWidth(1), fHeight(1),
     fPointer(), unmapCount(0),
     fGraphics(nullptr),
+    fDamage(nullptr),
     fEventMask(KeyPressMask|KeyReleaseMask|FocusChangeMask|
                LeaveWindowMask|EnterWindowMask),
     fWinGravity(NorthWestGravity), fBitGravity(ForgetGravity),
@@ -172,6 +173,11 @@ YWindow::~YWindow() {
     if (fGraphics) {
         delete fGraphics; fGraphics = nullptr;
     }
+    if (fDamage) {
+        xapp->undamaged(this);
+        XDestroyRegion(fDamage);
+        fDamage = nullptr;
+    }
     if (flags & wfCreated)
         destroy();
 }
@@ -608,32 +614,8 @@ void YWindow::handleEvent(const XEvent &event) {
         break;
 
     case MotionNotify:
-         {
-             XEvent new_event, old_event;
-
-             old_event = event;
-             while (/*XPending(app->display()) > 0 &&*/
-                    XCheckMaskEvent(xapp->display(),
-                                 KeyPressMask |
-                                 KeyReleaseMask |
-                                 ButtonPressMask |
-                                 ButtonReleaseMask |
-                                 ButtonMotionMask,
-                                 &new_event) == True)
-             {
-                 if (event.type != new_event.type ||
-                     event.xmotion.window != new_event.xmotion.window)
-                 {
-                     XPutBackEvent(xapp->display(), &new_event);
-                     break;
-                 } else {
-                     XSync(xapp->display(), False);
-                     old_event = new_event;
-                 }
-             }
-             handleMotion(old_event.xmotion);
-         }
-         break;
+        handleMotion(event.xmotion);
+        break;
 
     case EnterNotify:
     case LeaveNotify:
@@ -663,30 +645,7 @@ void YWindow::handleEvent(const XEvent &event) {
 
     case ConfigureNotify:
         updateEnterNotifySerial(event);
-#if 1
-         {
-             XEvent new_event, old_event;
-
-             old_event = event;
-             while (/*XPending(app->display()) > 0 &&*/
-                    XCheckTypedWindowEvent(xapp->display(), handle(), ConfigureNotify,
-                                 &new_event) == True)
-             {
-                 if (event.type != new_event.type ||
-                     event.xconfigure.window != new_event.xconfigure.window)
-                 {
-                     XPutBackEvent(xapp->display(), &new_event);
-                     break;
-                 } else {
-                     XFlush(xapp->display());
-                     old_event = new_event;
-                 }
-             }
-             handleConfigure(old_event.xconfigure);
-         }
-#else
-         handleConfigure(event.xconfigure);
-#endif
+        handleConfigure(event.xconfigure);
         break;
 
     case ConfigureRequest:
@@ -789,41 +748,57 @@ void YWindow::setDoubleBuffer(bool flag) {
     fDoubleBuffer = flag;
 }
 
-/// TODO #warning "implement expose compression"
 void YWindow::paintExpose(int ex, int ey, int ew, int eh) {
-    if (ex < 0) {
-        ew += ex;
-        ex = 0;
-    }
-    if (ey < 0) {
-        eh += ey;
-        ey = 0;
-    }
-    ew = min(ew, int(width()) - ex);
-    eh = min(eh, int(height()) - ey);
     if (ew > 0 && eh > 0) {
-        Graphics& g = getGraphics();
-        XRectangle r = {
-            short(ex),
-            short(ey),
-            static_cast<unsigned short>(ew),
-            static_cast<unsigned short>(eh),
-        };
-        g.setClipRectangles(&r, 1);
-        YRect r1(ex, ey, unsigned(ew), unsigned(eh));
-        if (fDoubleBuffer) {
-            ref<YPixmap> pixmap = beginPaint(r1);
-            Graphics g1(pixmap, ex, ey);
-            //MSG(("paint %d %d %d %d", ex, ey, ew, eh));
-            paint(g1, r1);
-            endPaint(g, pixmap, r1);
-        } else {
-            paint(g, r1);
+        addDamage(YRect(ex, ey, unsigned(ew), unsigned(eh)));
+    }
+}
+
+void YWindow::addDamage(const YRect& rect) {
+    YRect area(rect.intersect(YRect(0, 0, width(), height())));
+    if (area.pixels() == 0)
+        return;
+    if (fDamage == nullptr) {
+        fDamage = XCreateRegion();
+        xapp->damaged(this);
+    }
+    XRectangle r = {
+        short(area.x()),
+        short(area.y()),
+        static_cast<unsigned short>(area.width()),
+        static_cast<unsigned short>(area.height()),
+    };
+    XUnionRectWithRegion(&r, fDamage, fDamage);
+}
+
+void YWindow::paintDamage() {
+    if (fDamage) {
+        Region region = fDamage;
+        fDamage = nullptr;
+        XRectangle box;
+        XClipBox(region, &box);
+        if (box.width && box.height && destroyed() == false) {
+            paintRegion(region, YRect(box.x, box.y, box.width, box.height));
         }
-        g.resetClip();
+        XDestroyRegion(region);
     }
 }
 
+void YWindow::paintRegion(Region region, const YRect& bounds) {
+    Graphics& g = getGraphics();
+    g.setClipRegion(region);
+    YRect r1(bounds);
+    if (fDoubleBuffer) {
+        ref<YPixmap> pixmap = beginPaint(r1);
+        Graphics g1(pixmap, r1.x(), r1.y());
+        paint(g1, r1);
+        endPaint(g, pixmap, r1);
+    } else {
+        paint(g, r1);
+    }
+    g.resetClip();
+}
+
 void YWindow::handleExpose(const XExposeEvent &expose) {
     paintExpose(expose.x, expose.y, expose.width, expose.height);
 }
@@ -1187,23 +1162,24 @@ void YWindow::setPointer(const YCursor& pointer) {
     }
 }
 
-void YWindow::grabKeyM(int keycode, unsigned int modifiers) {
+void YWindow::grabKeyM(int keycode, unsigned int modifiers, bool sync) {
     MSG(("grabKey %d %d %s", keycode, modifiers,
          XKeysymToString(keyCodeToKeySym(keycode))));
 
     XGrabKey(xapp->display(), keycode, modifiers, handle(), False,
-             GrabModeAsync, GrabModeAsync);
+             GrabModeAsync, sync ? GrabModeSync : GrabModeAsync);
 }
 
-void YWindow::grabKey(int key, unsigned int modifiers) {
+void YWindow::grabKey(int key, unsigned int modifiers, bool sync) {
     KeyCode keycode = XKeysymToKeycode(xapp->display(), KeySym(key));
     if (keycode != 0) {
-        grabKeyM(keycode, modifiers);
+        grabKeyM(keycode, modifiers, sync);
         if (modifiers != AnyModifier) {
-            grabKeyM(keycode, modifiers | LockMask);
+            grabKeyM(keycode, modifiers | LockMask, sync);
             if (xapp->NumLockMask != 0) {
-                grabKeyM(keycode, modifiers | xapp->NumLockMask);
-                grabKeyM(keycode, modifiers | xapp->NumLockMask | LockMask);
+                grabKeyM(keycode, modifiers | xapp->NumLockMask, sync);
+                grabKeyM(keycode, modifiers | xapp->NumLockMask | LockMask,
+                         sync);
             }
         }
     }
@@ -1469,6 +1445,7 @@ void YWindow::removeAccelerator(unsigned int key, unsigned int mod, YWindow *win
 const Atom XdndCurrentVersion = 3;
 
 void YWindow::setProperty(Atom prop, Atom type, const Atom* values, int count) {
+    YPropertyCache::forget(handle(), prop);
     XChangeProperty(xapp->display(), handle(), prop, type, 32, PropModeReplace,
                     reinterpret_cast<const unsigned char *>(values), count);
 }
@@ -1477,6 +1454,24 @@ void YWindow::setProperty(Atom property, Atom propType, Atom value) {
     setProperty(property, propType, &value, 1);
 }
 
+void YWindow::appendProperty(Atom prop, Atom type, const Atom* values, int count) {
+    YPropertyCache::forget(handle(), prop);
+    XChangeProperty(xapp->display(), handle(), prop, type, 32, PropModeAppend,
+                    reinterpret_cast<const unsigned char *>(values), count);
+}
+
+void YWindow::setTextProperty(Atom prop, Atom type, const char* text) {
+    YPropertyCache::forget(handle(), prop);
+    XChangeProperty(xapp->display(), handle(), prop, type, 8, PropModeReplace,
+                    reinterpret_cast<const unsigned char *>(text),
+                    int(strlen(text)));
+}
+
+void YWindow::deleteProperty(Atom prop) {
+    YPropertyCache::forget(handle(), prop);
+    XDeleteProperty(xapp->display(), handle(), prop);
+}
+
 void YWindow::setNetWindowType(Atom window_type) {
     setProperty(_XA_NET_WM_WINDOW_TYPE, XA_ATOM, window_type);
 }
@@ -1496,7 +1491,7 @@ void YWindow::setDND(bool enabled) {
         if (fDND) {
             setProperty(XA_XdndAware, XA_ATOM, XdndCurrentVersion);
         } else {
-            XDeleteProperty(xapp->display(), handle(), XA_XdndAware);
+            deleteProperty(XA_XdndAware);
         }
     }
 }
@@ -1698,7 +1693,7 @@ YDesktop::~YDesktop() {
         desktop = nullptr;
 }
 
-void YWindow::grabVKey(int key, unsigned int vm) {
+void YWindow::grabVKey(int key, unsigned int vm, bool sync) {
     unsigned m = 0;
 
     if (vm & kfShift)
@@ -1724,7 +1719,7 @@ void YWindow::grabVKey(int key, unsigned int vm) {
             (!(vm & kfHyper) || xapp->HyperMask) &&
             (!(vm & kfAltGr) || xapp->ModeSwitchMask))
         {
-            grabKey(key, m);
+            grabKey(key, m, sync);
         }
 
         // !!! recheck this
@@ -1741,7 +1736,7 @@ void YWindow::grabVKey(int key, unsigned int vm) {
                 m |= xapp->HyperMask;
             if (vm & kfAltGr)
                 m |= xapp->ModeSwitchMask;
-            grabKey(key, m);
+            grabKey(key, m, sync);
         }
     }
 }
@@ -1918,7 +1913,7 @@ void YWindow::scrollWindow(int dx, int dy) {
     {
         XEvent e;
 
-        while (XCheckTypedWindowEvent(xapp->display(), handle(), GraphicsExpose, &e)) {
+        while (xapp->checkWindowEvent(handle(), GraphicsExpose, &e)) {
             handleGraphicsExpose(e.xgraphicsexpose);
             if (e.xgraphicsexpose.count == 0)
                 break;
@@ -83,6 +83,7 @@ public:
     virtual void configure(const YRect2& r2);
 
     virtual void paint(Graphics &g, const YRect &r);
+    virtual void paintRegion(Region region, const YRect& bounds);
 
     virtual void handleEvent(const XEvent &event);
 
@@ -130,9 +131,9 @@ public:
     void beginAutoScroll(bool autoScroll, const XMotionEvent *motion);
 
     void setPointer(const YCursor& pointer);
-    void grabKeyM(int key, unsigned modifiers);
-    void grabKey(int key, unsigned modifiers);
-    void grabVKey(int key, unsigned vmodifiers);
+    void grabKeyM(int key, unsigned modifiers, bool sync = false);
+    void grabKey(int key, unsigned modifiers, bool sync = false);
+    void grabVKey(int key, unsigned vmodifiers, bool sync = false);
     unsigned VMod(int modifiers);
     void grabButtonM(int button, unsigned modifiers);
     void grabButton(int button, unsigned modifiers);
@@ -148,6 +149,9 @@ public:
     ref<YPixmap> beginPaint(YRect &r);
     void endPaint(Graphics &g, ref<YPixmap> pixmap, YRect &r);
     void paintExpose(int ex, int ey, int ew, int eh);
+    // repaint this area once the current batch of events is done
+    void addDamage(const YRect& rect);
+    void paintDamage();
 
     Graphics& getGraphics();
     virtual ref<YImage> getGradient() {
@@ -215,6 +219,9 @@ public:
 
     void setProperty(Atom prop, Atom type, const Atom* values, int count);
     void setProperty(Atom property, Atom propType, Atom value);
+    void appendProperty(Atom prop, Atom type, const Atom* values, int count);
+    void setTextProperty(Atom prop, Atom type, const char* text);
+    void deleteProperty(Atom prop);
     void setNetWindowType(Atom window_type);
     void setNetOpacity(Atom opacity);
     void setNetPid();
@@ -288,6 +295,7 @@ private:
     YCursor fPointer;
     int unmapCount;
     Graphics *fGraphics;
+    Region fDamage;
     long fEventMask;
     int fWinGravity, fBitGravity;
 
@@ -8,6 +8,7 @@
 #include "yxcontext.h"
 #include "guievent.h"
 #include "intl.h"
+#include "yevstats.h"
 #undef override
 #include <X11/Xproto.h>
 #ifdef XINERAMA
@@ -56,6 +57,8 @@ Atom _XA_ICEWM_ACTION;
 Atom _XA_ICEWM_GUIEVENT;
 Atom _XA_ICEWM_HINT;
 Atom _XA_ICEWM_FONT_PATH;
+Atom _XA_ICEWM_EVENT_STATS;
+Atom _XA_ICEWM_RESTART_STATE;
 Atom _XA_ICEWMBG_IMAGE;
 Atom _XA_XROOTPMAP_ID;
 Atom _XA_XROOTCOLOR_PIXEL;
@@ -312,6 +315,8 @@ YAtomName YXApplication::atom_info[] = {
         { &_XA_ICEWM_GUIEVENT                   , XA_GUI_EVENT_NAME                     },
         { &_XA_ICEWM_HINT                       , "_ICEWM_WINOPTHINT"                   },
         { &_XA_ICEWM_FONT_PATH                  , "ICEWM_FONT_PATH"                     },
+        { &_XA_ICEWM_EVENT_STATS                , "_ICEWM_EVENT_STATS"                  },
+        { &_XA_ICEWM_RESTART_STATE              , "_ICEWM_RESTART_STATE"                },
         { &_XA_ICEWMBG_IMAGE                    , "_ICEWMBG_IMAGE"                     },
         { &_XA_XROOTPMAP_ID                     , "_XROOTPMAP_ID"                       },
         { &_XA_XROOTCOLOR_PIXEL                 , "_XROOTCOLOR_PIXEL"                   },
@@ -1003,6 +1008,16 @@ void YXApplication::dropClipboard() {
     fClip = null;
 }
 
+void YXApplication::eventStatistics() {
+    if (fEventStats == nullptr) {
+        fEventStats = new YEventStats();
+    }
+    mstring text(fEventStats->report());
+    XChangeProperty(display(), root(), _XA_ICEWM_EVENT_STATS,
+                    XA_STRING, 8, PropModeReplace,
+                    (const unsigned char *) text.c_str(), int(text.length()));
+}
+
 const char* YXApplication::getHelpText() {
     return _(
     "  -d, --display=NAME  NAME of the X server to use.\n"
@@ -1080,6 +1095,7 @@ YXApplication::YXApplication(int *argc, char ***argv, const char *displayName):
     lastEventTime(CurrentTime),
     fPopup(nullptr),
     xfd(this),
+    fEventStats(nullptr),
     fXGrabWindow(nullptr),
     fGrabWindow(nullptr),
     fGrabTree(false),
@@ -1129,73 +1145,270 @@ YXApplication::~YXApplication() {
     if (fColormap32 != CopyFromParent)
         XFreeColormap(xapp->display(), fColormap32);
 
+    delete fEventStats;
     xfd.unregisterPoll();
+    Graphics::freePool();
     XCloseDisplay(display());
     xapp = nullptr;
 }
 
+void YXEventQueue::enqueue(const XEvent& xev) {
+    if (merge(xev) == false) {
+        PRECONDITION(isFull() == false);
+        at(fCount++) = xev;
+    }
+}
+
+bool YXEventQueue::dequeue(XEvent* xev) {
+    while (fCount > 0) {
+        XEvent& head(at(0));
+        fHead = (fHead + 1) % Size;
+        fCount--;
+        if (head.type) {
+            *xev = head;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool YXEventQueue::extract(Window window, int type, XEvent* xev) {
+    for (int i = 0; i < fCount; ++i) {
+        XEvent& event(at(i));
+        if (event.type == type && event.xany.window == window) {
+            *xev = event;
+            event.type = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool YXEventQueue::extractMask(Window window, long mask, XEvent* xev) {
+    for (int i = 0; i < fCount; ++i) {
+        XEvent& event(at(i));
+        if (event.type && event.xany.window == window &&
+            (eventMask(event.type) & mask))
+        {
+            *xev = event;
+            event.type = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+// the event mask which selects an event type, as Xlib has it
+long YXEventQueue::eventMask(int type) {
+    switch (type) {
+    case KeyPress:          return KeyPressMask;
+    case KeyRelease:        return KeyReleaseMask;
+    case ButtonPress:       return ButtonPressMask;
+    case ButtonRelease:     return ButtonReleaseMask;
+    case MotionNotify:      return PointerMotionMask | ButtonMotionMask |
+                                   Button1MotionMask | Button2MotionMask |
+                                   Button3MotionMask | Button4MotionMask |
+                                   Button5MotionMask;
+    case EnterNotify:       return EnterWindowMask;
+    case LeaveNotify:       return LeaveWindowMask;
+    case FocusIn:
+    case FocusOut:          return FocusChangeMask;
+    case KeymapNotify:      return KeymapStateMask;
+    case Expose:
+    case GraphicsExpose:
+    case NoExpose:          return ExposureMask;
+    case VisibilityNotify:  return VisibilityChangeMask;
+    case CreateNotify:      return SubstructureNotifyMask;
+    case DestroyNotify:
+    case UnmapNotify:
+    case MapNotify:
+    case ReparentNotify:
+    case ConfigureNotify:
+    case GravityNotify:
+    case CirculateNotify:   return StructureNotifyMask |
+                                   SubstructureNotifyMask;
+    case MapRequest:
+    case ConfigureRequest:
+    case CirculateRequest:  return SubstructureRedirectMask;
+    case ResizeRequest:     return ResizeRedirectMask;
+    case PropertyNotify:    return PropertyChangeMask;
+    case ColormapNotify:    return ColormapChangeMask;
+    default:                return NoEventMask;
+    }
+}
+
+void YXEventQueue::putBack(Display* display) {
+    for (int i = fCount; 0 < i--; ) {
+        if (at(i).type)
+            XPutBackEvent(display, &at(i));
+    }
+    fHead = fCount = 0;
+}
+
+bool YXEventQueue::merge(const XEvent& xev) {
+    if (fCount == 0)
+        return false;
+
+    if (xev.type == MotionNotify) {
+        // only consecutive motion, to preserve order with buttons and keys
+        XEvent& last(at(fCount - 1));
+        if (last.type == MotionNotify &&
+            last.xmotion.window == xev.xmotion.window &&
+            last.xmotion.subwindow == xev.xmotion.subwindow &&
+            last.xmotion.state == xev.xmotion.state &&
+            last.xmotion.same_screen == xev.xmotion.same_screen)
+        {
+            last = xev;
+            return true;
+        }
+        return false;
+    }
+
+    if (xev.type != ConfigureNotify &&
+        xev.type != PropertyNotify)
+        return false;
+
+    // drop an older event which is superseded by this one
+    for (int i = fCount; 0 < i--; ) {
+        XEvent& old(at(i));
+        if (old.xany.window != xev.xany.window || old.type == 0)
+            continue;
+        if (old.type == xev.type) {
+            if (xev.type == ConfigureNotify &&
+                old.xconfigure.window != xev.xconfigure.window)
+                continue;
+            if (xev.type == PropertyNotify &&
+                old.xproperty.atom != xev.xproperty.atom)
+                continue;
+            old.type = 0;
+            return false;
+        }
+        // a change in structure must see the configuration before it
+        if (old.type == ReparentNotify ||
+            old.type == DestroyNotify ||
+            old.type == GravityNotify ||
+            old.type == MapNotify ||
+            old.type == UnmapNotify)
+            return false;
+    }
+    return false;
+}
+
 bool YXApplication::handleXEvents() {
-    const int prratio = 3;
+    // XPending flushes the output buffer and reads without blocking,
+    // once for each batch of events.
     int retrieved = 0;
-    for (; retrieved < XPending(display()); retrieved += prratio - 1) {
+    for (int pending = XPending(display());
+         0 < pending && fEvents.isFull() == false;
+         --pending, ++retrieved)
+    {
         XEvent xev;
-
         XNextEvent(display(), &xev);
+        fEvents.enqueue(xev);
+    }
+
+    XEvent xev;
+    while (fEvents.dequeue(&xev)) {
+        dispatchXEvent(xev);
+    }
+    return paintDamage() | (retrieved > 0);
+}
+
+bool YXApplication::paintDamage() {
+    // each window paints the union of its damage once per batch
+    bool painted = fDamaged.nonempty();
+    while (fDamaged.nonempty()) {
+        YWindow* window = fDamaged[0];
+        fDamaged.remove(0);
+        window->paintDamage();
+    }
+    return painted;
+}
+
+void YXApplication::dispatchXEvent(XEvent& xev) {
 #ifdef DEBUG
-        xeventcount++;
+    xeventcount++;
 #endif
-        //msg("%d", xev.type);
+    //msg("%d", xev.type);
 
-        saveEventTime(xev);
+    saveEventTime(xev);
 
-        if (loggingEvents) {
-            if (xev.type < LASTEvent)
-                logEvent(xev);
+    if (loggingEvents) {
+        if (xev.type < LASTEvent)
+            logEvent(xev);
 #ifdef CONFIG_SHAPE
-            else if (shapes.isEvent(xev.type, ShapeNotify))
-                logShape(xev);
+        else if (shapes.isEvent(xev.type, ShapeNotify))
+            logShape(xev);
 #endif
 #ifdef CONFIG_XRANDR
-            else if (xrandr.isEvent(xev.type, RRScreenChangeNotify))
-                logRandrScreen(xev);
-            else if (xrandr.isEvent(xev.type, RRNotify))
-                logRandrNotify(xev);
+        else if (xrandr.isEvent(xev.type, RRScreenChangeNotify))
+            logRandrScreen(xev);
+        else if (xrandr.isEvent(xev.type, RRNotify))
+            logRandrNotify(xev);
 #endif
-        }
+    }
 
-        if (filterEvent(xev)) {
+    // logEvent only sees the event before it is handled and is compiled
+    // out without LOGEVENTS, so the statistics wrap the dispatch here
+    YEventStats* const stats = fEventStats;
+    timeval start;
+    const char* outer = nullptr;
+    if (stats) {
+        start = monotime();
+        outer = stats->enter();
+    }
+
+    if (filterEvent(xev)) {
+    } else {
+        bool ge = xev.type == ButtonPress ||
+                  xev.type == ButtonRelease ||
+                  xev.type == MotionNotify ||
+                  xev.type == KeyPress ||
+                  xev.type == KeyRelease /*||
+                  xev.type == EnterNotify ||
+                  xev.type == LeaveNotify*/;
+
+        fReplayEvent = false;
+
+        if (fPopup && ge) {
+            if (stats)
+                stats->target(fPopup);
+            handleGrabEvent(fPopup, xev);
+        } else if (fGrabWindow && ge) {
+            if (stats)
+                stats->target(fGrabWindow);
+            handleGrabEvent(fGrabWindow, xev);
         } else {
-            bool ge = xev.type == ButtonPress ||
-                      xev.type == ButtonRelease ||
-                      xev.type == MotionNotify ||
-                      xev.type == KeyPress ||
-                      xev.type == KeyRelease /*||
-                      xev.type == EnterNotify ||
-                      xev.type == LeaveNotify*/;
-
-            fReplayEvent = false;
-
-            if (fPopup && ge) {
-                handleGrabEvent(fPopup, xev);
-            } else if (fGrabWindow && ge) {
-                handleGrabEvent(fGrabWindow, xev);
-            } else {
-                handleWindowEvent(xev.xany.window, xev);
-            }
-            if (fGrabWindow) {
-                if (xev.type == ButtonPress ||
-                    xev.type == ButtonRelease ||
-                    xev.type == MotionNotify)
-                {
-                    if (!fReplayEvent) {
-                        XAllowEvents(xapp->display(), SyncPointer, CurrentTime);
-                    }
+            handleWindowEvent(xev.xany.window, xev);
+        }
+        if (fGrabWindow) {
+            if (xev.type == ButtonPress ||
+                xev.type == ButtonRelease ||
+                xev.type == MotionNotify)
+            {
+                if (!fReplayEvent) {
+                    XAllowEvents(xapp->display(), SyncPointer, CurrentTime);
                 }
             }
         }
-        XFlush(display());
     }
-    return retrieved > 0;
+    if (stats) {
+        stats->leave(xev.type, start, outer);
+    }
+}
+
+bool YXApplication::checkWindowEvent(Window window, int type, XEvent* xev) {
+    return fEvents.extract(window, type, xev)
+        || XCheckTypedWindowEvent(display(), window, type, xev);
+}
+
+bool YXApplication::checkMaskEvent(Window window, long mask, XEvent* xev) {
+    return fEvents.extractMask(window, mask, xev)
+        || XCheckWindowEvent(display(), window, mask, xev);
+}
+
+void YXApplication::requeueEvents() {
+    fEvents.putBack(display());
 }
 
 bool YXApplication::handleIdle() {
@@ -1209,6 +1422,8 @@ void YXApplication::handleWindowEvent(Window xwindow, XEvent &xev) {
 
     if (windowContext.find(xwindow, &window.ptr))
     {
+        if (fEventStats)
+            fEventStats->target(window.ptr);
         if ((xev.type == KeyPress || xev.type == KeyRelease)
             && window.ptr->toplevel())
         {
@@ -1358,9 +1573,13 @@ void YProperty::discard() {
 const YProperty& YProperty::update() {
     discard();
     int fmt = 0;
-    if (XGetWindowProperty(xapp->display(), fWind, fProp, 0L, fLimit, fDelete,
-                           fKind, &fType, &fmt, &fSize, &fMore, &fData) ==
-        Success && fData && fSize && fmt == fBits && (fKind == fType || !fKind))
+    if (((!fDelete &&
+          YPropertyCache::property(fWind, fProp, fLimit, fKind,
+                                   &fType, &fmt, &fSize, &fMore, &fData)) ||
+         XGetWindowProperty(xapp->display(), fWind, fProp, 0L, fLimit, fDelete,
+                            fKind, &fType, &fmt, &fSize, &fMore, &fData) ==
+         Success) &&
+        fData && fSize && fmt == fBits && (fKind == fType || !fKind))
     {
     } else {
         discard();
@@ -1368,4 +1587,40 @@ const YProperty& YProperty::update() {
     return *this;
 }
 
+YPropertyCache* YPropertyCache::fCurrent;
+
+bool YPropertyCache::property(Window window, Atom prop, long limit,
+                              Atom kind, Atom* type, int* format,
+                              unsigned long* count, unsigned long* after,
+                              unsigned char** data)
+{
+    for (YPropertyCache* cache = fCurrent; cache; cache = cache->fOuter) {
+        if (cache->cachedProperty(window, prop, limit, kind,
+                                  type, format, count, after, data))
+            return true;
+    }
+    return false;
+}
+
+bool YPropertyCache::properties(Window window, Atom** atoms, int* count) {
+    for (YPropertyCache* cache = fCurrent; cache; cache = cache->fOuter) {
+        if (cache->cachedProperties(window, atoms, count))
+            return true;
+    }
+    return false;
+}
+
+void YPropertyCache::forget(Window window, Atom prop) {
+    for (YPropertyCache* cache = fCurrent; cache; cache = cache->fOuter) {
+        cache->forgetProperty(window, prop);
+    }
+}
+
+Atom* listProperties(Window window, int* count) {
+    Atom* atoms = nullptr;
+    if (YPropertyCache::properties(window, &atoms, count))
+        return atoms;
+    return XListProperties(xapp->display(), window, count);
+}
+
 // vim: set sw=4 ts=4 et:
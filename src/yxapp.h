@@ -77,6 +77,40 @@ private:
     bool fDelete;
 };
 
+// Window properties which were requested in advance of their use.
+// While caches exist, YProperty and listProperties consult them first
+// and only make a round trip to the X server for what they lack.
+class YPropertyCache {
+public:
+    // a copy of a property, to be freed by XFree, false if not cached
+    static bool property(Window window, Atom prop, long limit, Atom kind,
+                         Atom* type, int* format, unsigned long* count,
+                         unsigned long* after, unsigned char** data);
+    // a copy of the property list of a window, false if not cached
+    static bool properties(Window window, Atom** atoms, int* count);
+    // a property was changed by us
+    static void forget(Window window, Atom prop);
+
+protected:
+    YPropertyCache() : fOuter(fCurrent) { fCurrent = this; }
+    virtual ~YPropertyCache() { fCurrent = fOuter; }
+
+    virtual bool cachedProperty(Window window, Atom prop, long limit,
+                                Atom kind, Atom* type, int* format,
+                                unsigned long* count, unsigned long* after,
+                                unsigned char** data) = 0;
+    virtual bool cachedProperties(Window window, Atom** atoms,
+                                  int* count) = 0;
+    virtual void forgetProperty(Window window, Atom prop) = 0;
+
+private:
+    YPropertyCache* fOuter;
+    static YPropertyCache* fCurrent;
+};
+
+// like XListProperties, but served from a cache if possible
+Atom* listProperties(Window window, int* count);
+
 class YXPoll: public YPoll<class YXApplication> {
 public:
     explicit YXPoll(YXApplication* owner) : YPoll(owner) { }
@@ -84,6 +118,36 @@ public:
     virtual bool forRead() { return true; }
 };
 
+// X events which were read from the display, but not yet dispatched.
+// Redundant motion, configure and property events are merged.
+// Expose areas are accumulated per window as damage, see YWindow.
+class YXEventQueue {
+public:
+    YXEventQueue() : fHead(0), fCount(0) { }
+
+    bool isEmpty() const { return fCount == 0; }
+    bool isFull() const { return fCount == Size; }
+    int length() const { return fCount; }
+
+    void enqueue(const XEvent& xev);
+    bool dequeue(XEvent* xev);
+    // remove the first queued event of this type for this window
+    bool extract(Window window, int type, XEvent* xev);
+    // remove the first queued event matching the mask for this window
+    bool extractMask(Window window, long mask, XEvent* xev);
+    // return all queued events to the Xlib queue in order
+    void putBack(Display* display);
+
+private:
+    enum { Size = 64 };
+    XEvent& at(int i) { return fEvents[(fHead + i) % Size]; }
+    bool merge(const XEvent& xev);
+    static long eventMask(int type);
+
+    XEvent fEvents[Size];
+    int fHead, fCount;
+};
+
 class YXApplication: public YApplication {
 public:
     YXApplication(int *argc, char ***argv, const char *displayName = nullptr);
@@ -122,6 +186,17 @@ public:
                     bool grabMouse = true, bool grabKeyboard = true,
                     bool grabTree = false);
     bool releaseEvents();
+    // check the event queues for an event of this type for this window
+    bool checkWindowEvent(Window window, int type, XEvent* xev);
+    // like XCheckWindowEvent, but also looks at the batched events
+    bool checkMaskEvent(Window window, long mask, XEvent* xev);
+    // events in Xlib's queue and in the current batch
+    int pendingEvents() const { return QLength(fDisplay) + fEvents.length(); }
+    // before reading events directly from Xlib in a modal loop
+    void requeueEvents();
+    // windows with damage to paint after the current batch of events
+    void damaged(YWindow* window) { fDamaged.append(window); }
+    void undamaged(YWindow* window) { findRemove(fDamaged, window); }
     void handleGrabEvent(YWindow *win, XEvent &xev);
     virtual bool handleIdle();
     void handleWindowEvent(Window xwindow, XEvent &xev);
@@ -147,6 +222,9 @@ public:
     void setClipboardText(mstring data);
     void dropClipboard();
 
+    // collect dispatch statistics or store them in _ICEWM_EVENT_STATS
+    void eventStatistics();
+
     static YCursor leftPointer;
     static YCursor rightPointer;
     static YCursor movePointer;
@@ -204,6 +282,7 @@ private:
     YXPoll xfd;
 
     lazy<class YClipboard> fClip;
+    class YEventStats* fEventStats;
     YWindow *fXGrabWindow;
     YWindow *fGrabWindow;
 
@@ -211,8 +290,13 @@ private:
     bool fGrabMouse;
     bool fReplayEvent;
 
+    YXEventQueue fEvents;
+    YArray<YWindow*> fDamaged;
+
     virtual bool handleXEvents();
     virtual void flushXEvents();
+    void dispatchXEvent(XEvent& xev);
+    bool paintDamage();
 
     void initModifiers();
     static void initAtoms();
@@ -0,0 +1,94 @@
+/*
+ * IceWM - map windows to objects
+ */
+#include "config.h"
+#include "yxcontext.h"
+#include "base.h"
+#include <stdlib.h>
+
+YAnyContext::~YAnyContext() {
+    if (verbose) {
+        tlog("%s: destroyed", title);
+    }
+    free(table);
+}
+
+void YAnyContext::resize(unsigned capacity) {
+    Slot* old = table;
+    unsigned size = old ? mask + 1 : 0;
+
+    table = static_cast<Slot *>(calloc(capacity, sizeof(Slot)));
+    if (table == nullptr) {
+        table = old;
+        return;
+    }
+    mask = capacity - 1;
+    for (unsigned k = 0; k < size; ++k) {
+        if (old[k].key) {
+            unsigned i = home(old[k].key);
+            while (table[i].key)
+                i = (i + 1) & mask;
+            table[i] = old[k];
+        }
+    }
+    free(old);
+
+    if (verbose) {
+        tlog("%s: resized to %u for %u", title, capacity, count);
+    }
+}
+
+void YAnyContext::save(Window w, AnyPointer p) {
+    if (w == None)
+        return;
+
+    // keep the load factor below 3/4
+    if (table == nullptr || 4 * (count + 1) > 3 * (mask + 1))
+        resize(table ? 2 * (mask + 1) : 64);
+
+    unsigned i = home(w);
+    while (table[i].key && table[i].key != w)
+        i = (i + 1) & mask;
+    if (table[i].key == None) {
+        table[i].key = w;
+        count += 1;
+    }
+    table[i].value = p;
+
+    if (verbose) {
+        tlog("%s: save 0x%lx to %p", title, w, p);
+    }
+}
+
+bool YAnyContext::remove(Window w) {
+    unsigned i = home(w);
+    if (table && w) {
+        while (table[i].key && table[i].key != w)
+            i = (i + 1) & mask;
+    }
+    if (table == nullptr || w == None || table[i].key == None) {
+        if (verbose) {
+            tlog("%s: remove for 0x%lx failed", title, w);
+        }
+        return false;
+    }
+
+    // shift back later entries which would no longer be found
+    for (unsigned j = (i + 1) & mask; table[j].key; j = (j + 1) & mask) {
+        unsigned k = home(table[j].key);
+        if (((j - k) & mask) >= ((j - i) & mask)) {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i].key = None;
+    table[i].value = nullptr;
+    count -= 1;
+
+    if (verbose) {
+        tlog("%s: remove for 0x%lx", title, w);
+    }
+    return true;
+}
+
+// vim: set sw=4 ts=4 et:
@@ -1,80 +1,70 @@
 #ifndef __YXCONTEXT_H
 #define __YXCONTEXT_H
 
-#ifndef NULLQUARK
-#include <X11/Xresource.h>
-#endif
+#include <X11/X.h>
 
+// Map windows to pointers in an open-addressing hash table with
+// linear probing. Removal shifts back the following entries of the
+// same probe sequence, so no tombstones are needed.
 class YAnyContext {
 protected:
     typedef void* AnyPointer;
 
 private:
-    XContext unique;
+    struct Slot {
+        Window key;
+        AnyPointer value;
+    };
+
+    Slot* table;
+    unsigned mask;
+    unsigned count;
     const char* title;
     const bool verbose;
 
-    XContext context() {
-        if (unique == 0) {
-            unique = XUniqueContext();
-            if (verbose) {
-                tlog("%s: created", title);
-            }
-        }
-        return unique;
+    unsigned home(Window w) const {
+        unsigned long h = w ^ (w >> 16);
+        return unsigned(h * 2654435761UL) & mask;
     }
 
-    Display* dpy() const { return xapp->display(); }
+    void resize(unsigned capacity);
+
+    YAnyContext(const YAnyContext&);
+    YAnyContext& operator=(const YAnyContext&);
 
 public:
     YAnyContext(const char* title = nullptr, bool verbose = false) :
-        unique(0),
+        table(nullptr),
+        mask(0),
+        count(0),
         title(title),
         verbose(verbose)
     {
     }
 
-    ~YAnyContext() {
-        if (verbose) {
-            tlog("%s: destroyed", title);
-        }
-    }
+    ~YAnyContext();
 
     // store mapping of window to pointer
-    void save(Window w, AnyPointer p) {
-        const char* q = static_cast<const char *>(p);
-        XSaveContext(dpy(), w, context(), q);
-        if (verbose) {
-            tlog("%s: save 0x%lx to %p", title, w, p);
-        }
-    }
+    void save(Window w, AnyPointer p);
 
     // lookup pointer by window
-    bool find(Window w, AnyPointer* p) {
-        char* q = nullptr;
-        int rc = XFindContext(dpy(), w, context(), &q);
-        if (verbose) {
-            if (rc == 0)
-                tlog("%s: find 0x%lx found %p", title, w,
-                        reinterpret_cast<void *>(p));
-            else
-                tlog("%s: find 0x%lx not found", title, w);
+    bool find(Window w, AnyPointer* p) const {
+        if (table && w) {
+            for (unsigned i = home(w); table[i].key; i = (i + 1) & mask) {
+                if (table[i].key == w) {
+                    *p = table[i].value;
+                    return true;
+                }
+            }
         }
-        *p = q;
-        return rc == 0;
+        *p = nullptr;
+        return false;
     }
 
     // remove mapping of window to pointer
-    bool remove(Window w) {
-        int rc = XDeleteContext(dpy(), w, context());
-        if (verbose) {
-            if (rc == 0)
-                tlog("%s: remove for 0x%lx", title, w);
-            else
-                tlog("%s: remove for 0x%lx failed", title, w);
-        }
-        return rc == 0;
-    }
+    bool remove(Window w);
+
+    unsigned size() const { return count; }
 };
 
 template <typename T>
@@ -90,7 +80,7 @@ public:
     }
 
     // lookup pointer by window
-    bool find(Window w, TPtr* ptr) {
+    bool find(Window w, TPtr* ptr) const {
         AnyPointer p = nullptr;
         if (YAnyContext::find(w, &p)) {
             *ptr = TPtr(p);
@@ -100,7 +90,7 @@ public:
     }
 
     // lookup pointer by window
-    TPtr find(Window w) {
+    TPtr find(Window w) const {
         AnyPointer p = nullptr;
         YAnyContext::find(w, &p);
         return TPtr(p);
@@ -110,6 +100,8 @@ public:
     bool remove(Window w) {
         return YAnyContext::remove(w);
     }
+
+    using YAnyContext::size;
 };
 
 class YFrameClient;
@@ -17,6 +17,13 @@
 
 #include <X11/xpm.h>
 
+#ifdef HAVE_SYS_SHM_H
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/socket.h>
+#include <X11/extensions/XShm.h>
+#endif
+
 #ifdef CONFIG_LIBJPEG
 #include <jpeglib.h>
 #include <setjmp.h>
@@ -42,6 +49,262 @@ struct Verbose {
 
 static Verbose verbose;
 
+#ifdef HAVE_SYS_SHM_H
+
+// Large images are transferred through a MIT-SHM segment, which the
+// X server reads and writes directly, instead of through the socket.
+// One segment of up to KeepSize is kept for the next transfer, larger
+// ones are released after use.  Remote displays use XPutImage/XGetImage.
+class ShmTransfer {
+public:
+    ShmTransfer() : fState(Unknown), fSize(0), fSerial(0) {
+        fSegment.shmseg = None;
+        fSegment.shmid = -1;
+        fSegment.shmaddr = nullptr;
+        fSegment.readOnly = False;
+    }
+
+    bool putImage(Drawable d, GC gc, XImage* image, int dx, int dy);
+    XImage* getImage(Drawable d, int x, int y,
+                     unsigned w, unsigned h, unsigned depth);
+    void destroyImage(XImage* image);
+
+private:
+    enum { MinSize = 64 * 1024, KeepSize = 4 * 1024 * 1024 };
+    enum State { Unknown, Supported, Unsupported };
+
+    State fState;
+    XShmSegmentInfo fSegment;
+    size_t fSize;
+    unsigned long fSerial;  // last request which reads the segment
+
+    bool usable(size_t size);
+    bool acquire(size_t size);
+    void detach();
+    XImage* create(unsigned depth, int format, unsigned w, unsigned h);
+    bool owns(XImage* image) const {
+        return image->obdata == (char *) &fSegment;
+    }
+
+    static unsigned long attachSerial;
+    static bool attachFailed;
+    static XErrorHandler previousHandler;
+    static int attachError(Display* display, XErrorEvent* xev);
+};
+
+unsigned long ShmTransfer::attachSerial;
+bool ShmTransfer::attachFailed;
+XErrorHandler ShmTransfer::previousHandler;
+
+static ShmTransfer shmTransfer;
+
+int ShmTransfer::attachError(Display* display, XErrorEvent* xev) {
+    if (xev->serial == attachSerial) {
+        attachFailed = true;
+        return Success;
+    }
+    return previousHandler ? previousHandler(display, xev) : Success;
+}
+
+bool ShmTransfer::usable(size_t size) {
+    if (size < MinSize || fState == Unsupported)
+        return false;
+    if (fState == Unknown) {
+        // a forwarded display may look local, but only a unix socket
+        // guarantees that the server shares our memory
+        sockaddr_storage addr;
+        socklen_t len = sizeof addr;
+        bool local = getsockname(ConnectionNumber(xapp->display()),
+                                 (sockaddr *) &addr, &len) == 0
+                  && addr.ss_family == AF_UNIX;
+        fState = local && XShmQueryExtension(xapp->display())
+               ? Supported : Unsupported;
+        if (verbose)
+            tlog("MIT-SHM is %s", fState == Supported ? "used" : "unused");
+    }
+    return fState == Supported;
+}
+
+bool ShmTransfer::acquire(size_t size) {
+    Display* dpy = xapp->display();
+    if (fSegment.shmaddr && size <= fSize) {
+        // the server may still have to read the previous transfer
+        if (LastKnownRequestProcessed(dpy) < fSerial)
+            XSync(dpy, False);
+        return true;
+    }
+    detach();
+
+    size_t pages = (size + 0xFFFF) & ~size_t(0xFFFF);
+    fSegment.shmid = shmget(IPC_PRIVATE, pages, IPC_CREAT | 0600);
+    if (fSegment.shmid == -1) {
+        if (verbose)
+            fail("shmget %zu", pages);
+        return false;
+    }
+    fSegment.shmaddr = (char *) shmat(fSegment.shmid, nullptr, 0);
+    if (fSegment.shmaddr == (char *) -1) {
+        if (verbose)
+            fail("shmat %zu", pages);
+        shmctl(fSegment.shmid, IPC_RMID, nullptr);
+        fSegment.shmaddr = nullptr;
+        return false;
+    }
+    fSegment.readOnly = False;
+
+    attachFailed = false;
+    attachSerial = NextRequest(dpy);
+    previousHandler = XSetErrorHandler(attachError);
+    XShmAttach(dpy, &fSegment);
+    XSync(dpy, False);
+    XSetErrorHandler(previousHandler);
+    previousHandler = nullptr;
+
+    // the segment is freed as soon as both sides have detached
+    shmctl(fSegment.shmid, IPC_RMID, nullptr);
+
+    if (attachFailed) {
+        tlog("MIT-SHM attach failed, using XPutImage instead");
+        fState = Unsupported;
+        shmdt(fSegment.shmaddr);
+        fSegment.shmaddr = nullptr;
+        return false;
+    }
+    fSize = pages;
+    return true;
+}
+
+void ShmTransfer::detach() {
+    if (fSegment.shmaddr) {
+        // requests which are still queued are ordered before the detach
+        XShmDetach(xapp->display(), &fSegment);
+        shmdt(fSegment.shmaddr);
+        fSegment.shmaddr = nullptr;
+        fSize = 0;
+    }
+}
+
+XImage* ShmTransfer::create(unsigned depth, int format,
+                            unsigned w, unsigned h)
+{
+    Visual* visual = depth == 1 ? xapp->visual() : xapp->visualForDepth(depth);
+    if (visual == nullptr)
+        return nullptr;
+    return XShmCreateImage(xapp->display(), visual, depth, format,
+                           nullptr, &fSegment, w, h);
+}
+
+bool ShmTransfer::putImage(Drawable d, GC gc, XImage* image, int dx, int dy) {
+    Display* dpy = xapp->display();
+    if (owns(image)) {
+        fSerial = NextRequest(dpy);
+        XShmPutImage(dpy, d, gc, image, 0, 0, dx, dy,
+                     image->width, image->height, False);
+        return true;
+    }
+    if (image->xoffset || !usable(size_t(image->bytes_per_line) * image->height))
+        return false;
+
+    XImage* shm = create(image->depth, image->format,
+                         image->width, image->height);
+    if (shm == nullptr)
+        return false;
+    const size_t size = size_t(shm->bytes_per_line) * shm->height;
+    if (shm->bits_per_pixel != image->bits_per_pixel ||
+        shm->byte_order != image->byte_order ||
+        shm->bitmap_bit_order != image->bitmap_bit_order ||
+        !acquire(size))
+    {
+        XDestroyImage(shm);
+        return false;
+    }
+
+    // rows may be padded differently
+    shm->data = fSegment.shmaddr;
+    const int stride = min(shm->bytes_per_line, image->bytes_per_line);
+    for (int y = 0; y < image->height; ++y) {
+        memcpy(shm->data + y * shm->bytes_per_line,
+               image->data + y * image->bytes_per_line, stride);
+    }
+    fSerial = NextRequest(dpy);
+    XShmPutImage(dpy, d, gc, shm, 0, 0, dx, dy,
+                 shm->width, shm->height, False);
+    XDestroyImage(shm);
+    if (fSize > KeepSize)
+        detach();
+    return true;
+}
+
+XImage* ShmTransfer::getImage(Drawable d, int x, int y,
+                              unsigned w, unsigned h, unsigned depth)
+{
+    if (fState == Unsupported || depth == 1)
+        return nullptr;
+    XImage* shm = create(depth, ZPixmap, w, h);
+    if (shm == nullptr)
+        return nullptr;
+    const size_t size = size_t(shm->bytes_per_line) * shm->height;
+    if (!usable(size) || !acquire(size)) {
+        XDestroyImage(shm);
+        return nullptr;
+    }
+    shm->data = fSegment.shmaddr;
+    if (!XShmGetImage(xapp->display(), d, shm, x, y, AllPlanes)) {
+        XDestroyImage(shm);
+        return nullptr;
+    }
+    return shm;
+}
+
+void ShmTransfer::destroyImage(XImage* image) {
+    if (owns(image)) {
+        // frees only the XImage, not the segment
+        XDestroyImage(image);
+        if (fSize > KeepSize)
+            detach();
+    } else {
+        XDestroyImage(image);
+    }
+}
+
+static void putImage(Drawable d, GC gc, XImage* image, int dx, int dy) {
+    if (!shmTransfer.putImage(d, gc, image, dx, dy))
+        XPutImage(xapp->display(), d, gc, image, 0, 0, dx, dy,
+                  image->width, image->height);
+}
+
+static XImage* getImage(Drawable d, int x, int y,
+                        unsigned w, unsigned h, unsigned depth)
+{
+    XImage* image = shmTransfer.getImage(d, x, y, w, h, depth);
+    if (image == nullptr)
+        image = XGetImage(xapp->display(), d, x, y, w, h, AllPlanes, ZPixmap);
+    return image;
+}
+
+static void destroyImage(XImage* image) {
+    shmTransfer.destroyImage(image);
+}
+
+#else
+
+static void putImage(Drawable d, GC gc, XImage* image, int dx, int dy) {
+    XPutImage(xapp->display(), d, gc, image, 0, 0, dx, dy,
+              image->width, image->height);
+}
+
+static XImage* getImage(Drawable d, int x, int y,
+                        unsigned w, unsigned h, unsigned depth)
+{
+    return XGetImage(xapp->display(), d, x, y, w, h, AllPlanes, ZPixmap);
+}
+
+static void destroyImage(XImage* image) {
+    XDestroyImage(image);
+}
+
+#endif
+
 class YXImage: public YImage {
 public:
     YXImage(XImage *ximage, bool bitmap = false) :
@@ -972,7 +1235,7 @@ ref<YImage> YImage::createFromPixmapAndMask(Pixmap pixmap, Pixmap mask,
     if (d == 1)
         xdraw = XGetImage(xapp->display(), pixmap, 0, 0, w, h, 0x1, XYPixmap);
     else
-        xdraw = XGetImage(xapp->display(), pixmap, 0, 0, w, h, AllPlanes, ZPixmap);
+        xdraw = getImage(pixmap, 0, 0, w, h, d);
 
     // tlog("next request %lu at %s: +%d : %s()\n", NextRequest(xapp->display()), __FILE__, __LINE__, __func__);
     if (xdraw && (!mask || (xmask = XGetImage(xapp->display(), mask, 0, 0, w, h, 0x1, XYPixmap)))) {
@@ -982,7 +1245,7 @@ ref<YImage> YImage::createFromPixmapAndMask(Pixmap pixmap, Pixmap mask,
         image = YXImage::combine(xdraw, xmask);
     }
     if (xdraw)
-        XDestroyImage(xdraw);
+        destroyImage(xdraw);
     if (xmask)
         XDestroyImage(xmask);
     return image;
@@ -1129,7 +1392,7 @@ ref <YPixmap> YXImage::renderToPixmap(unsigned depth, bool premult)
         }
         // tlog("putting ximage %ux%ux%u to pixmap\n", xdraw->width, xdraw->height, xdraw->depth);
         // tlog("next request %lu at %s: +%d : %s()\n", NextRequest(xapp->display()), __FILE__, __LINE__, __func__);
-        XPutImage(xapp->display(), draw, gcd, xdraw, 0, 0, 0, 0, xdraw->width, xdraw->height);
+        putImage(draw, gcd, xdraw, 0, 0);
 
         // tlog("next request %lu at %s: +%d : %s()\n", NextRequest(xapp->display()), __FILE__, __LINE__, __func__);
         mask = XCreatePixmap(xapp->display(), xapp->root(), xmask->width, xmask->height, 1);
@@ -1147,7 +1410,7 @@ ref <YPixmap> YXImage::renderToPixmap(unsigned depth, bool premult)
         XSetBackground(xapp->display(), gcm, 0x00000000);
         // tlog("putting ximage %ux%ux%u to mask\n", xmask->width, xmask->height, xmask->depth);
         // tlog("next request %lu at %s: +%d : %s()\n", NextRequest(xapp->display()), __FILE__, __LINE__, __func__);
-        XPutImage(xapp->display(), mask, gcm, xmask, 0, 0, 0, 0, xmask->width, xmask->height);
+        putImage(mask, gcm, xmask, 0, 0);
 
         pixmap = createPixmap(draw, mask, xdraw->width, xdraw->height, depth);
         draw = mask = None; // consumed above
@@ -1215,7 +1478,7 @@ void YXImage::composite(Graphics& g, int x, int y,
     tlog("compositing %ux%u+%d+%d of %ux%ux%u onto drawable 0x%lx at +%d+%d\n", w, h, x, y, wi, hi, di, g.drawable(), dx, dy);
     Window root;
     int _x, _y;
-    unsigned _w, _h, _b, _d;
+    unsigned _w = 0, _h = 0, _b = 0, _d = 0;
 
     if (XGetGeometry(xapp->display(), g.drawable(), &root, &_x, &_y, &_w, &_h, &_b, &_d))
         if (verbose)
@@ -1273,7 +1536,7 @@ void YXImage::composite(Graphics& g, int x, int y,
     if (verbose)
     tlog("getting image %ux%u+%d+%d from drawable %ux%ux%u\n", w, h, dx-g.xorigin(), dy-g.yorigin(), _w, _h, _d);
     // tlog("next request %lu at %s: +%d : %s()\n", NextRequest(xapp->display()), __FILE__, __LINE__, __func__);
-    xback = XGetImage(xapp->display(), g.drawable(), dx - g.xorigin(), dy - g.yorigin(), w, h, AllPlanes, ZPixmap);
+    xback = getImage(g.drawable(), dx - g.xorigin(), dy - g.yorigin(), w, h, _d ? _d : g.rdepth());
     if (!xback) {
         tlog("ERROR: could not get backing image\n");
         xback = createImage(w, h, g.rdepth());
@@ -1325,8 +1588,8 @@ void YXImage::composite(Graphics& g, int x, int y,
     tlog("putting %ux%u+0+0 of ximage %ux%ux%u on drawable %ux%ux%u at +%d+%d\n",
           w, h, xback->width, xback->height, xback->depth, _w, _h, _d, dx-g.xorigin(), dy-g.yorigin());
     // tlog("next request %lu at %s: +%d : %s()\n", NextRequest(xapp->display()), __FILE__, __LINE__, __func__);
-    XPutImage(xapp->display(), g.drawable(), g.handleX(), xback, 0, 0, dx - g.xorigin(), dy - g.yorigin(), w, h);
-    XDestroyImage(xback);
+    putImage(g.drawable(), g.handleX(), xback, dx - g.xorigin(), dy - g.yorigin());
+    destroyImage(xback);
 }
 
 void image_init()